@@ -0,0 +1,355 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// emulator core throughput benchmark : no SDL, no GUI
+// runs fixed workloads and reports the emulated cycles per host second as JSON,
+// and the time taken by a full redraw of the screen in each video mode
+//
+//   reinette-bench [-r runs] [-o file.json] [workload ...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "reinette.h"
+
+bool  running = true;
+bool  paused  = false;
+float speed   = 1.023f;
+bool  turbo   = true;
+float mhz     = 0.0f;
+
+Mmu*       mmu     = new Mmu();
+puce65c02* cpu     = new puce65c02();
+Video*     video   = new Video();
+Disk*      disk    = new Disk();
+Paddles*   paddles = new Paddles();
+Heatmap*   heatmap = new Heatmap();
+#ifdef TRACE
+Trace*     trace   = new Trace();
+#endif
+
+
+static const uint8_t aluLoop[] = {                                              // loaded at $0800
+  0xA2, 0x00,                                                                   // 0800 LDX #$00
+  0xA0, 0x00,                                                                   // 0802 LDY #$00
+  0x18,                                                                         // 0804 CLC
+  0xBD, 0x00, 0x09,                                                             // 0805 LDA $0900,X
+  0x69, 0x07,                                                                   // 0808 ADC #$07
+  0x65, 0x10,                                                                   // 080A ADC $10
+  0x85, 0x10,                                                                   // 080C STA $10
+  0x9D, 0x00, 0x0A,                                                             // 080E STA $0A00,X
+  0x45, 0x11,                                                                   // 0811 EOR $11
+  0x85, 0x11,                                                                   // 0813 STA $11
+  0xE8,                                                                         // 0815 INX
+  0xD0, 0xEC,                                                                   // 0816 BNE $0804
+  0xC8,                                                                         // 0818 INY
+  0x4C, 0x04, 0x08                                                              // 0819 JMP $0804
+};
+
+static const uint8_t lcLoop[] = {                                               // loaded at $0800
+  0xAD, 0x83, 0xC0,                                                             // 0800 LDA $C083   bank 2, read RAM
+  0xAD, 0x83, 0xC0,                                                             // 0803 LDA $C083   and write enable
+  0xEE, 0x00, 0xD0,                                                             // 0806 INC $D000
+  0xAD, 0x8B, 0xC0,                                                             // 0809 LDA $C08B   bank 1, read RAM
+  0xAD, 0x8B, 0xC0,                                                             // 080C LDA $C08B   and write enable
+  0xEE, 0x00, 0xD0,                                                             // 080F INC $D000
+  0xAD, 0x82, 0xC0,                                                             // 0812 LDA $C082   ROM only
+  0xAD, 0x00, 0xE0,                                                             // 0815 LDA $E000
+  0x8D, 0x09, 0xC0,                                                             // 0818 STA $C009   AUX zero page
+  0xA5, 0x10,                                                                   // 081B LDA $10
+  0x8D, 0x08, 0xC0,                                                             // 081D STA $C008   MAIN zero page
+  0x4C, 0x00, 0x08                                                              // 0820 JMP $0800
+};
+
+
+typedef struct Workload_t {
+  const char* name;
+  const char* image;                                                            // floppy in drive 0, NULL to run code
+  const uint8_t* code;                                                          // program run from $0800 when no image
+  int codeSize;
+  const char* keys;                                                             // typed during the warmup
+  unsigned long long int warmup;                                                // untimed cycles (boot, loading)
+  unsigned long long int cycles;                                                // timed cycles
+} Workload;
+
+static const Workload workloads[] = {
+  { "alu_loop",     NULL, aluLoop, sizeof(aluLoop), NULL, 0, 200000000ULL },
+  { "lc_switch",    NULL, lcLoop,  sizeof(lcLoop),  NULL, 0, 100000000ULL },
+  { "dos33_boot",   "nib/dos/DOS3.3 Blank.nib",                        NULL, 0, NULL,              0,         20000000ULL },
+  { "hgr_oldskool", "nib/demo/oldskool.nib",                           NULL, 0, "BRUN OLDSKOOL\r", 30000000ULL, 60000000ULL },
+  { "hgr_outline",  "nib/demo/outline2021.nib",                        NULL, 0, NULL,              10000000ULL, 60000000ULL },
+  { "gr_sierzoom",  "nib/demo/sierzoom128.nib",                        NULL, 0, " ",               20000000ULL, 60000000ULL },
+  { "dhgr_robocop", "nib/128K/Robocop (1988)(Data East)(Disk 1 of 2).nib", NULL, 0, NULL,          10000000ULL, 60000000ULL }
+};
+
+
+typedef struct Render_t {
+  const char* name;
+  uint8_t mode;                                                                 // display switches, VM_ bits
+} Render;
+
+static const Render renders[] = {
+  { "render_text40", VM_TEXT },
+  { "render_text80", VM_TEXT | VM_COL80 },
+  { "render_gr",     0 },
+  { "render_dgr",    VM_DHIRES },
+  { "render_hgr",    VM_HIRES },
+  { "render_dhgr",   VM_HIRES | VM_DHIRES }
+};
+
+#define RENDER_FRAMES 2000
+
+
+typedef struct Conversion_t {
+  const char* name;
+  bool toSectors;                                                               // .dsk image to nibbles, or back
+} Conversion;
+
+static const Conversion conversions[] = {
+  { "nibblize_dsk",   false },
+  { "denibblize_dsk", true }
+};
+
+#define CONVERSION_IMAGE "nib/dos/DOS3.3 Blank.nib"                             // its sectors are the .dsk image
+#define CONVERSIONS 200
+
+
+static void powerOn(const Workload* w) {                                        // every run of a workload is the same
+  cpu->ticks = 0;
+  video->frameNumber = 0;
+  paddles->reset();
+  mmu->init();
+  video->clearCache();
+  disk->eject(0);
+  disk->unit[0].motorOn = false;
+  if (w->image && !disk->load((char*)w->image, 0)) {
+    fprintf(stderr, "Could not load %s\n", w->image);
+    exit(EXIT_FAILURE);
+  }
+  cpu->RST();
+  if (w->code) {                                                                // no ROM boot, run the program directly
+    memcpy(mmu->ram + 0x0800, w->code, w->codeSize);
+    cpu->setPC(0x0800);
+  }
+}
+
+
+static void runFrames(const Workload* w, unsigned long long int cycles, const char** keys) {
+  unsigned long long int target = cpu->ticks + cycles;
+
+  if (w->code) {                                                                // plain cpu workload, no video
+    while (cpu->ticks < target)
+      cpu->exec(1000000);
+    return;
+  }
+
+  while (cpu->ticks < target) {                                                 // same frame pacing as the GUI
+    if (keys && *keys && **keys && !(mmu->KBD & 0x80))
+      mmu->KBD = *(*keys)++ | 0x80;                                             // previous key was read, type the next one
+
+    cpu->exec((unsigned long long int)(1000000.0 * speed / 60));
+
+    unsigned long long int burst = cpu->ticks + DISK_BURST;                     // speed up drive access
+    while (disk->accelerated && disk->unit[disk->curDrv].motorOn && cpu->ticks < burst)
+      cpu->exec(5000);
+
+    video->update();
+    if (++video->frameNumber >= 60) video->frameNumber = 0;
+  }
+}
+
+
+static void fillScreens(const Render* r) {                                       // pseudo random page 1 contents
+  uint32_t seed = 0x2A2A2A2A;
+  mmu->init();
+  for (int address = 0x0400; address < 0x4000; address++) {                     // TEXT, GR and HGR, MAIN and AUX
+    seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;                  // xorshift32
+    mmu->ram[address] = seed;
+    mmu->aux[address] = seed >> 8;
+  }
+  mmu->TEXT   = r->mode & VM_TEXT;
+  mmu->HIRES  = r->mode & VM_HIRES;
+  mmu->DHIRES = r->mode & VM_DHIRES;
+  mmu->COL80  = r->mode & VM_COL80;
+  video->setMode();
+  cpu->ticks += CYCLES_PER_FRAME;                                               // let the beam draw a frame in this mode
+}
+
+
+static bool wanted(const char* name, const char** selected, int numSelected) {
+  bool found = numSelected == 0;
+  for (int i = 0; i < numSelected; i++)
+    found |= !strcmp(selected[i], name);
+  return found;
+}
+
+
+static bool toSectors(const uint8_t* nibbles, uint8_t* sectors) {               // the 35 tracks, all sectors found
+  bool ok = true;
+  for (int track = 0; track < 35; track++)
+    ok = Disk::denibblize(nibbles, sectors, IMG_DOS, track) && ok;
+  return ok;
+}
+
+
+int main(int argc, char *argv[]) {
+  int runs = 3;
+  const char* output = NULL;
+  const char* selected[16];
+  int numSelected = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-r") && i + 1 < argc) runs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc) output = argv[++i];
+    else if (argv[i][0] != '-' && numSelected < 16) selected[numSelected++] = argv[i];
+    else {
+      fprintf(stderr, "usage: %s [-r runs] [-o file.json] [workload ...]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (runs < 1) runs = 1;
+
+  FILE* f = output ? fopen(output, "w") : stdout;
+  if (!f) {
+    fprintf(stderr, "Could not write %s\n", output);
+    return EXIT_FAILURE;
+  }
+
+  fprintf(f, "{\n  \"version\": \"%s\",\n  \"compiler\": \"%s\",\n", VERSION, __VERSION__);
+#ifdef HEATMAP
+  fprintf(f, "  \"heatmap\": true,\n");
+#else
+  fprintf(f, "  \"heatmap\": false,\n");
+#endif
+#ifdef TRACE
+  fprintf(f, "  \"trace\": true,\n");
+#else
+  fprintf(f, "  \"trace\": false,\n");
+#endif
+#ifdef THREADED
+  fprintf(f, "  \"dispatch\": \"threaded\",\n");
+#else
+  fprintf(f, "  \"dispatch\": \"switch\",\n");
+#endif
+  fprintf(f, "  \"runs\": %d,\n  \"workloads\": [", runs);
+
+  int count = 0;
+  for (const Workload& w : workloads) {
+    if (!wanted(w.name, selected, numSelected)) continue;
+
+    double best = 0.0;                                                          // fastest run, in seconds
+    unsigned long long int executed = 0;
+
+    for (int run = 0; run < runs; run++) {
+      powerOn(&w);
+      const char* keys = w.keys;
+      runFrames(&w, w.warmup, &keys);
+
+      unsigned long long int start = cpu->ticks;
+      auto begin = std::chrono::steady_clock::now();
+      runFrames(&w, w.cycles, &keys);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+      if (run == 0 || elapsed.count() < best) {
+        best = elapsed.count();
+        executed = cpu->ticks - start;
+      }
+    }
+
+    fprintf(f, "%s\n    { \"name\": \"%s\", \"cycles\": %llu, \"seconds\": %.6f, \"mhz\": %.3f }",
+            count++ ? "," : "", w.name, executed, best, executed / best / 1000000.0);
+    fflush(f);
+  }
+
+  fprintf(f, "\n  ],\n  \"render\": [");
+  count = 0;
+  for (const Render& r : renders) {
+    if (!wanted(r.name, selected, numSelected)) continue;
+
+    double best = 0.0;
+    for (int run = 0; run < runs; run++) {
+      fillScreens(&r);
+      auto begin = std::chrono::steady_clock::now();
+      for (int frame = 0; frame < RENDER_FRAMES; frame++) {
+        video->clearCache();                                                    // every line is redrawn
+        video->update();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+      if (run == 0 || elapsed.count() < best)
+        best = elapsed.count();
+    }
+
+    fprintf(f, "%s\n    { \"name\": \"%s\", \"frames\": %d, \"seconds\": %.6f, \"us_per_frame\": %.2f }",
+            count++ ? "," : "", r.name, RENDER_FRAMES, best, best / RENDER_FRAMES * 1000000.0);
+    fflush(f);
+  }
+  fprintf(f, "\n  ],\n  \"images\": [");
+  count = 0;
+  static uint8_t sectors[DSK_SIZE];
+  static uint8_t checked[DSK_SIZE];
+  for (const Conversion& c : conversions) {
+    if (!wanted(c.name, selected, numSelected)) continue;
+    if (!count) {                                                               // once : the image goes both ways unchanged
+      if (!disk->load((char*)CONVERSION_IMAGE, 0)) {
+        fprintf(stderr, "Could not load %s\n", CONVERSION_IMAGE);
+        exit(EXIT_FAILURE);
+      }
+      bool ok = toSectors(disk->unit[0].data, sectors);
+      Disk::nibblize(sectors, disk->unit[0].data, IMG_DOS);
+      if (!ok || !toSectors(disk->unit[0].data, checked) || memcmp(sectors, checked, DSK_SIZE)) {
+        fprintf(stderr, "%s does not convert back to the same sectors\n", CONVERSION_IMAGE);
+        exit(EXIT_FAILURE);
+      }
+    }
+
+    bool ok = true;
+    double best = 0.0;
+    for (int run = 0; run < runs; run++) {
+      auto begin = std::chrono::steady_clock::now();
+      for (int i = 0; i < CONVERSIONS; i++) {
+        if (c.toSectors)
+          ok = toSectors(disk->unit[0].data, sectors) && ok;
+        else
+          Disk::nibblize(sectors, disk->unit[0].data, IMG_DOS);
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+      if (run == 0 || elapsed.count() < best)
+        best = elapsed.count();
+    }
+    if (!ok) {
+      fprintf(stderr, "%s : sectors missing\n", c.name);
+      exit(EXIT_FAILURE);
+    }
+
+    fprintf(f, "%s\n    { \"name\": \"%s\", \"images\": %d, \"seconds\": %.6f, \"us_per_image\": %.2f }",
+            count++ ? "," : "", c.name, CONVERSIONS, best, best / CONVERSIONS * 1000000.0);
+    fflush(f);
+  }
+  fprintf(f, "\n  ]\n}\n");
+
+  if (output) fclose(f);
+  return 0;
+}
@@ -0,0 +1,216 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <chrono>
+#include "reinette.h"
+
+Core::Core() {
+  scrub = 0;
+  codeAddress = -1;
+  codeShown = false;
+  ramShown = auxShown = false;
+  heatmapShown[MAIN_BANK] = heatmapShown[AUX_BANK] = false;
+  traceShown = false;
+  message = NULL;
+  state = new State();
+  quit = false;
+  for (int i = 0; i < 2; i++) {
+    pendingFirst[i] = 0;                                                        // the GUI textures start with
+    pendingLast[i]  = 192;                                                      // whatever the video buffers hold
+  }
+}
+
+
+Core::~Core() {
+  delete state;
+}
+
+
+void Core::start() {
+  quit = false;
+  thread = std::thread(&Core::loop, this);
+}
+
+
+void Core::stop() {
+  quit = true;
+  if (thread.joinable()) thread.join();
+}
+
+
+bool Core::post(std::function<void()> command) {                                // from the GUI thread only
+  return commands.push(std::move(command));
+}
+
+
+bool Core::latest(Frame** frame) {                                              // from the GUI thread only
+  return frames.read(frame);
+}
+
+
+//======================================================================= LOOP
+
+void Core::loop() {
+  using clock = std::chrono::steady_clock;
+  const clock::duration period = std::chrono::microseconds(1000000 / CORE_FPS);
+  clock::time_point deadline = clock::now();
+  clock::time_point mhzTime = deadline;                                         // to measure the emulated speed
+  unsigned long long int mhzTicks = cpu->ticks;
+  clock::time_point saveTime = deadline;                                        // last autosave
+
+  while (!quit) {
+    std::function<void()> command;
+    while (commands.pop(command)) command();                                    // inputs and actions from the GUI
+
+    paddles->update();
+    journal->poll();                                                            // buttons and paddles moved by the user
+
+    if (scrub) {                                                                // F9 held : one capture per frame
+      if (scrub < 0) history->back();
+      else history->forward();
+    }
+    else if (!paused && turbo) {                                                // run flat out, publish at TURBO_FPS
+      clock::time_point end = clock::now() + std::chrono::microseconds(1000000 / TURBO_FPS);
+      do {                                                                      // whole video frames per slice
+        cpu->exec(CYCLES_PER_FRAME);
+      } while (clock::now() < end);
+      history->update();                                                        // at most one capture per slice
+    }
+    else if (!paused) {
+      cpu->exec((unsigned long long int)(1000000.0 * speed / CORE_FPS));        // the apple II is clocked at 1023000.0 Hhz
+
+      unsigned long long int burst = cpu->ticks + DISK_BURST;                   // speed up drive access
+      while (disk->accelerated && disk->unit[disk->curDrv].motorOn && cpu->ticks < burst
+             && clock::now() < deadline + period)                               // within the frame
+        cpu->exec(5000);
+      history->update();
+    }
+    else if (cpu->state == step) {                                              // paused and user pressed debugNumber
+      cpu->exec(1);
+      cpu->state = run;                                                         // still paused
+      history->update();
+    }
+
+    video->update();
+    if (++video->frameNumber >= 60) video->frameNumber = 0;                     // reset to zero every second
+
+    clock::time_point now = clock::now();
+    if (now - mhzTime >= std::chrono::seconds(1)) {                             // update the emulated speed every second
+      if (cpu->ticks >= mhzTicks)                                               // unless an older state was restored
+        mhz = (float)((cpu->ticks - mhzTicks) / std::chrono::duration<double, std::micro>(now - mhzTime).count());
+      mhzTime = now;
+      mhzTicks = cpu->ticks;
+    }
+    if (disk->autosave && now - saveTime >= std::chrono::seconds(AUTOSAVE)) {   // the floppies written to
+      saveTime = now;
+      if (!disk->flush()) {
+        disk->autosave = false;                                                 // don't insist
+        message = "Could not save the floppy, autosave is off";
+      }
+    }
+
+    publish();
+
+    if (turbo && !paused && !scrub) {                                           // turbo slices are paced already
+      deadline = clock::now();
+      continue;
+    }
+    deadline += period;                                                         // real time, without catching up
+    if (deadline < clock::now()) deadline = clock::now();                       // when late
+    else std::this_thread::sleep_until(deadline);
+  }
+}
+
+
+//==================================================================== PUBLISH
+
+void Core::publish() {
+  Frame* f = frames.writing();                                                  // the GUI is not reading this one
+
+  f->gfxmode = video->gfxmode;
+  if (video->gfxmode == 80)
+    memcpy(f->screenPixels80, video->screenPixels80, sizeof(f->screenPixels80));
+  else
+    memcpy(f->screenPixels, video->screenPixels, sizeof(f->screenPixels));
+  for (int i = 0; i < 2; i++) {
+    if (video->drawnFirst[i] < pendingFirst[i]) pendingFirst[i] = video->drawnFirst[i];
+    if (video->drawnLast[i]  > pendingLast[i])  pendingLast[i]  = video->drawnLast[i];
+    f->drawnFirst[i] = pendingFirst[i];
+    f->drawnLast[i]  = pendingLast[i];
+  }
+
+  if (ramShown) memcpy(f->ram, mmu->ram, RAMSIZE);                              // 48K each, only for the memory windows
+  if (auxShown) memcpy(f->aux, mmu->aux, AUXSIZE);
+  f->KBD = mmu->KBD;
+  f->TEXT = mmu->TEXT;   f->MIXED = mmu->MIXED;   f->PAGE2 = mmu->PAGE2;   f->HIRES = mmu->HIRES;
+  f->DHIRES = mmu->DHIRES; f->COL80 = mmu->COL80; f->ALTCHARSET = mmu->ALTCHARSET;
+  f->LCRD = mmu->LCRD;   f->LCWR = mmu->LCWR;     f->LCBK2 = mmu->LCBK2;   f->LCWFF = mmu->LCWFF;
+  f->RAMRD = mmu->RAMRD; f->RAMWRT = mmu->RAMWRT; f->ALTZP = mmu->ALTZP;   f->STORE80 = mmu->STORE80;
+  f->INTCXROM = mmu->INTCXROM; f->SLOTC3ROM = mmu->SLOTC3ROM;
+  f->inVBL = video->inVBL();
+  f->beamLine = video->beamLine();
+  cpu->getRegs(f->regs);
+  int address = codeAddress;
+  if (codeShown) cpu->getCode(address < 0 ? cpu->getPC() : address, f->code, sizeof(f->code), 20);
+  for (int drv = 0; drv < 2; drv++) {
+    memcpy(f->fileName[drv], disk->unit[drv].fileName, sizeof(f->fileName[drv]));
+    f->readOnly[drv]  = disk->unit[drv].readOnly;
+    f->motorOn[drv]   = disk->unit[drv].motorOn;
+    f->writeMode[drv] = disk->unit[drv].writeMode;
+  }
+  f->GCActionSpeed  = paddles->GCActionSpeed;
+  f->GCReleaseSpeed = paddles->GCReleaseSpeed;
+  f->speed  = speed;
+  f->mhz    = mhz;
+  f->turbo  = turbo;
+  f->fastDisk = disk->accelerated;
+  f->autosave = disk->autosave;
+  f->paused = paused;
+  f->muted  = muted;
+  f->volume = volume;
+  f->recording = journal->recording;
+  f->rewindSeconds = history->seconds();
+  f->rewindUsed    = history->used;
+  f->rewindBudget  = history->budget;
+#ifdef HEATMAP
+  for (int bank = 0; bank < 2; bank++) {
+    if (!heatmapShown[bank]) continue;                                          // converted to pixels only when visible
+    memcpy(f->heatmap[bank], heatmap->expand(bank), sizeof(f->heatmap[bank]));
+  }
+#endif
+#ifdef TRACE
+  if (traceShown) trace->list(f->trace, sizeof(f->trace), TRACE_LINES);         // disassembled only when visible
+#endif
+
+  if (!frames.publish()) {                                                      // the GUI took the previous frame,
+    for (int i = 0; i < 2; i++) {                                               // it only lacks the lines of this one
+      pendingFirst[i] = video->drawnFirst[i];
+      pendingLast[i]  = video->drawnLast[i];
+    }
+  }
+  video->clearDrawn(0);
+  video->clearDrawn(1);
+}
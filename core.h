@@ -0,0 +1,162 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __CORE_H__
+#define __CORE_H__
+
+#include <atomic>
+#include <thread>
+#include <functional>
+
+// the emulation runs on its own thread, paced at CORE_FPS. The GUI never
+// touches the machine : it posts its inputs and actions as commands to a lock
+// free queue, run by the core before its next frame, and shows the last Frame
+// completed by the core, taken from a triple buffer.
+
+#define CORE_FPS  60                                                            // emulated frames per second
+#define TURBO_FPS 30                                                            // frames published in turbo mode
+#define TRACE_LINES 200                                                         // last instructions in the TRACE window
+
+template <typename T, unsigned int N> class Queue {                             // single producer, single consumer
+  T slots[N];
+  std::atomic<unsigned int> head{0};                                            // next slot to pop
+  std::atomic<unsigned int> tail{0};                                            // next slot to push
+
+public:
+  bool push(T&& value) {
+    unsigned int t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == N) return false;            // full
+    slots[t % N] = std::move(value);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T& value) {
+    unsigned int h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return false;                // empty
+    value = std::move(slots[h % N]);
+    slots[h % N] = T();                                                         // release what it holds
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+
+template <typename T> class TripleBuffer {                                      // the writer never waits for the reader
+  T* buffers;
+  int back;                                                                     // being written
+  int front;                                                                    // being read
+  std::atomic<int> middle;                                                      // last one written, FRESH until read
+  static const int FRESH = 4;
+
+public:
+  TripleBuffer() : buffers(new T[3]()), back(0), front(1), middle(2) {}
+  ~TripleBuffer() { delete[] buffers; }
+
+  T* writing() { return &buffers[back]; }
+
+  bool publish() {                                                              // false if the previous one was read
+    int old = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+    back = old & 3;
+    return old & FRESH;
+  }
+
+  bool read(T** buffer) {                                                       // true if it is a new one
+    bool fresh = middle.load(std::memory_order_acquire) & FRESH;
+    if (fresh) front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+    *buffer = &buffers[front];
+    return fresh;
+  }
+};
+
+
+typedef struct Frame_t {
+  uint32_t screenPixels[280*192];                                               // only the one of gfxmode is copied
+  uint32_t screenPixels80[560*384];
+  int gfxmode;
+  int drawnFirst[2];                                                            // lines that changed since the frame
+  int drawnLast[2];                                                             // the GUI took before, at most
+
+  // the debug views, as the machine was at the end of the frame
+  uint8_t ram[RAMSIZE];                                                         // only when ramShown
+  uint8_t aux[AUXSIZE];                                                         // only when auxShown
+  uint8_t KBD;
+  bool TEXT, MIXED, PAGE2, HIRES, DHIRES, COL80, ALTCHARSET;
+  bool LCRD, LCWR, LCBK2, LCWFF;
+  bool RAMRD, RAMWRT, ALTZP, STORE80, INTCXROM, SLOTC3ROM;
+  bool inVBL;
+  int beamLine;
+  char regs[1000];
+  char code[2000];                                                              // only when codeShown
+  char fileName[2][400];
+  bool readOnly[2], motorOn[2], writeMode[2];
+  int GCActionSpeed, GCReleaseSpeed;
+  float speed, mhz;
+  bool turbo, paused, muted, recording, fastDisk, autosave;
+  int volume;
+  double rewindSeconds;
+  size_t rewindUsed, rewindBudget;
+#ifdef HEATMAP
+  uint32_t heatmap[2][0x10000];                                                 // only when heatmapShown
+#endif
+#ifdef TRACE
+  char trace[TRACE_LINES * 100];                                                // only when traceShown
+#endif
+} Frame;
+
+
+class Core {
+public:
+  std::atomic<int> scrub;                                                       // F9 held : -1 rewinding, 1 forward, 0 running
+  std::atomic<int> codeAddress;                                                 // disassembled in the frames, -1 follows the PC
+  std::atomic<bool> codeShown;                                                  // reading the code has side effects on I/O
+  std::atomic<bool> ramShown;                                                   // STACK, PAGE ZERO or RAM windows
+  std::atomic<bool> auxShown;
+  std::atomic<bool> heatmapShown[2];
+  std::atomic<bool> traceShown;
+  std::atomic<const char*> message;                                             // an error for the GUI to show, or NULL
+  State* state;                                                                 // quick save (F2), core thread only
+
+  Core();
+  ~Core();
+
+  void start();
+  void stop();
+  bool post(std::function<void()> command);                                     // run on the core thread, in order
+  bool latest(Frame** frame);                                                   // true if it was not shown yet
+
+private:
+  std::thread thread;
+  std::atomic<bool> quit;
+  Queue<std::function<void()>, 1024> commands;
+  TripleBuffer<Frame> frames;
+  int pendingFirst[2];                                                          // lines drawn since the frame
+  int pendingLast[2];                                                           // the GUI took before
+
+  void loop();
+  void publish();
+};
+
+#endif
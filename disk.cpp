@@ -24,22 +24,416 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <array>
+#include <filesystem>
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include "reinette.h"
 
+// DOS 3.3 16 sectors format : each sector is an address field (volume, track,
+// sector) followed by a data field of 343 nibbles, the 256 bytes split in 6 and
+// 2 bits values, chained by XOR and translated into valid disk nibbles
+
+#define TRACK_SIZE 0x1A00
+#define VOLUME     254
+#define GAP1       48                                                           // sync bytes at the start of a track
+#define GAP2       6                                                            // between address and data fields
+#define GAP3       44                                                           // after each data field, 16 sectors fill a track
+
+static const uint8_t writeTable[64] = {                                         // 6 bits values to disk nibbles
+  0x96, 0x97, 0x9A, 0x9B, 0x9D, 0x9E, 0x9F, 0xA6, 0xA7, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 0xB2, 0xB3,
+  0xB4, 0xB5, 0xB6, 0xB7, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF, 0xCB, 0xCD, 0xCE, 0xCF, 0xD3,
+  0xD6, 0xD7, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF, 0xE5, 0xE6, 0xE7, 0xE9, 0xEA, 0xEB, 0xEC,
+  0xED, 0xEE, 0xEF, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+};
+
+static constexpr std::array<uint8_t, 256> readNibbles() {                       // and back, 0xFF for invalid nibbles
+  std::array<uint8_t, 256> table = {};
+  for (int i = 0; i < 256; i++) table[i] = 0xFF;
+  for (int i = 0; i < 64; i++) table[writeTable[i]] = i;
+  return table;
+}
+static constexpr std::array<uint8_t, 256> readTable = readNibbles();            // built at compile time, for any thread
+
+static constexpr std::array<uint32_t, 256> crcs() {                             // for the WOZ files checksum
+  std::array<uint32_t, 256> table = {};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++)
+      crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+    table[i] = crc;
+  }
+  return table;
+}
+static constexpr std::array<uint32_t, 256> crcTable = crcs();
+
+static const uint8_t swap2[4] = { 0, 2, 1, 3 };                                 // the 2 bits values are stored reversed
+
+static const uint8_t dosOrder[16]    = { 0, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 15 };  // physical to file sector
+static const uint8_t prodosOrder[16] = { 0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15 };
+
+
 Disk::Disk() {
   curDrv = 0;                                                                   // Current Drive - only one can be enabled at a time
   // TODO : initialize the unit[x] structs
 }
 
 
+static int sectorOrder(const char* path) {                                      // .po images are in ProDOS order
+  const char* dot = strrchr(path, '.');
+  if (dot && tolower(dot[1]) == 'p' && tolower(dot[2]) == 'o' && !dot[3])
+    return IMG_PRODOS;
+  return IMG_DOS;                                                               // .dsk and .do
+}
+
+
+static uint8_t* encode44(uint8_t* p, uint8_t value) {                           // address field values, odd bits then even bits
+  *p++ = (value >> 1) | 0xAA;
+  *p++ = value | 0xAA;
+  return p;
+}
+
+
+static uint8_t* encode62(uint8_t* p, const uint8_t* sector) {                   // 256 bytes into 343 nibbles
+  uint8_t six[342];
+  for (int i = 0; i < 86; i++)                                                  // low bits of bytes i, i+86 and i+172
+    six[i] = swap2[sector[i] & 3] | swap2[sector[i + 86] & 3] << 2 | (i < 84 ? swap2[sector[i + 172] & 3] << 4 : 0);
+  for (int i = 0; i < 256; i++)                                                 // followed by their high bits
+    six[86 + i] = sector[i] >> 2;
+
+  uint8_t previous = 0;
+  for (int i = 0; i < 342; i++) {
+    *p++ = writeTable[six[i] ^ previous];
+    previous = six[i];
+  }
+  *p++ = writeTable[previous];                                                  // checksum
+  return p;
+}
+
+
+static inline uint8_t at(const uint8_t* track, int pos) {                       // the track is a loop
+  return track[pos % TRACK_SIZE];
+}
+
+
+static bool decode62(const uint8_t* track, int pos, uint8_t* sector) {          // 343 nibbles back into 256 bytes
+  uint8_t six[342];
+  uint8_t previous = 0;
+  for (int i = 0; i < 342; i++) {
+    uint8_t value = readTable[at(track, pos + i)];
+    if (value == 0xFF) return false;
+    six[i] = previous ^= value;
+  }
+  if (readTable[at(track, pos + 342)] != previous) return false;                // bad checksum
+
+  for (int i = 0; i < 256; i++)
+    sector[i] = six[86 + i] << 2 | swap2[(six[i % 86] >> (i / 86 * 2)) & 3];
+  return true;
+}
+
+
+static bool prologue(const uint8_t* track, int pos, uint8_t last) {
+  return at(track, pos) == 0xD5 && at(track, pos + 1) == 0xAA && at(track, pos + 2) == last;
+}
+
+
+void Disk::nibblize(const uint8_t* image, uint8_t* nibbles, int format) {
+  const uint8_t* order = format == IMG_PRODOS ? prodosOrder : dosOrder;
+
+  for (int track = 0; track < 35; track++) {
+    uint8_t* p = nibbles + track * TRACK_SIZE;
+    memset(p, 0xFF, GAP1);
+    p += GAP1;
+    for (int sector = 0; sector < 16; sector++) {
+      *p++ = 0xD5; *p++ = 0xAA; *p++ = 0x96;                                    // address field
+      p = encode44(p, VOLUME);
+      p = encode44(p, track);
+      p = encode44(p, sector);
+      p = encode44(p, VOLUME ^ track ^ sector);
+      *p++ = 0xDE; *p++ = 0xAA; *p++ = 0xEB;
+      memset(p, 0xFF, GAP2);
+      p += GAP2;
+      *p++ = 0xD5; *p++ = 0xAA; *p++ = 0xAD;                                    // data field
+      p = encode62(p, image + (track * 16 + order[sector]) * 256);
+      *p++ = 0xDE; *p++ = 0xAA; *p++ = 0xEB;
+      memset(p, 0xFF, GAP3);
+      p += GAP3;
+    }
+  }
+}
+
+
+bool Disk::denibblize(const uint8_t* nibbles, uint8_t* image, int format, int track) {  // false if a sector was not found
+  const uint8_t* order = format == IMG_PRODOS ? prodosOrder : dosOrder;
+  const uint8_t* t = nibbles + track * TRACK_SIZE;
+  uint16_t found = 0;                                                           // one bit per sector
+
+  for (int pos = 0; pos < TRACK_SIZE; pos++) {                                  // fields are where the DOS wrote them
+    if (!prologue(t, pos, 0x96)) continue;
+    uint8_t field[4];                                                           // volume, track, sector, checksum
+    for (int i = 0; i < 4; i++)
+      field[i] = ((at(t, pos + 3 + 2 * i) << 1) | 1) & at(t, pos + 4 + 2 * i);
+    if ((field[0] ^ field[1] ^ field[2]) != field[3] || field[1] != track || field[2] > 15)
+      continue;
+
+    for (int data = pos + 14; data < pos + 14 + 64; data++) {                   // the data field follows closely
+      if (prologue(t, data, 0x96)) break;                                       // or not at all
+      if (prologue(t, data, 0xAD)) {
+        if (decode62(t, data + 3, image + (track * 16 + order[field[2]]) * 256))
+          found |= 1 << field[2];
+        break;
+      }
+    }
+  }
+  return found == 0xFFFF;
+}
+
+
+// WOZ images : a header, then INFO, TMAP and TRKS chunks among others. TMAP
+// gives the track under each quarter track position, TRKS the bit streams.
+// The data register only depends on the bits that went under the head, so the
+// disk ][ logic state sequencer is run once on each track when loaded, giving
+// the value of the latch at each bit cell : leading zeros are lost, that's the
+// sync, and a complete nibble (MSB set) stays readable for two bit cells. The
+// head then moves at the pace of cpu->ticks. WOZ floppies are write protected.
+
+static uint32_t le16(const uint8_t* p) { return p[0] | p[1] << 8; }
+static uint32_t le32(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+
+
+static uint32_t crc32(const uint8_t* p, size_t size) {
+  uint32_t crc = ~0U;
+  while (size--)
+    crc = crcTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+
+int Disk::loadWoz(const uint8_t* file, size_t size, int drive) {
+  if (size < 12 || memcmp(file, "WOZ", 3) || (file[3] != '1' && file[3] != '2') || memcmp(file + 4, "\xFF\n\r\n", 4))
+    return 0;
+  if (le32(file + 8) && le32(file + 8) != crc32(file + 12, size - 12))          // 0 when not computed
+    return 0;
+  int version = file[3] - '0';
+
+  Woz woz = {};
+  memset(woz.tmap, 0xFF, sizeof(woz.tmap));
+  woz.timing = 32;
+  const uint8_t* trks = NULL;
+  uint32_t trksSize = 0;
+  bool info = false, tmap = false;
+
+  for (size_t pos = 12; pos + 8 <= size; ) {                                    // chunks : id, size, data
+    const uint8_t* chunk = file + pos + 8;
+    uint32_t length = le32(file + pos + 4);
+    if (length > size - pos - 8) return 0;
+    if (!memcmp(file + pos, "INFO", 4) && length >= 60) {
+      if (chunk[1] != 1) return 0;                                              // not a 5.25 floppy
+      if (chunk[0] >= 2 && chunk[39]) woz.timing = chunk[39];                   // optimal bit timing, WOZ 2 only
+      info = true;
+    }
+    if (!memcmp(file + pos, "TMAP", 4) && length >= 160) {
+      memcpy(woz.tmap, chunk, 160);
+      tmap = true;
+    }
+    if (!memcmp(file + pos, "TRKS", 4)) {
+      trks = chunk;
+      trksSize = length;
+    }
+    pos += 8 + length;
+  }
+  if (!info || !tmap || !trks) return 0;
+
+  int tracks = version == 1 ? trksSize / 6656 : 160;                            // WOZ 1 : fixed 6656 bytes records
+  if (version == 2 && trksSize < 160 * 8) return 0;                             // WOZ 2 : 160 TRK entries, then the bits
+  if (tracks > 160) tracks = 160;
+
+  const uint8_t* source[160] = {};
+  uint32_t used = 0;
+  for (int track = 0; track < tracks; track++) {                                // check every track before touching the drive
+    const uint8_t* bits;
+    uint32_t count;
+    if (version == 1) {
+      bits = trks + track * 6656;
+      count = le16(bits + 6648);
+      if (count > 6646 * 8) return 0;
+    } else {
+      const uint8_t* trk = trks + track * 8;
+      uint32_t start = le16(trk) * 512, blocks = le16(trk + 2);
+      count = le32(trk + 4);
+      if (start + blocks * 512 > size || count > blocks * 4096) return 0;
+      bits = file + start;
+    }
+    if (!count) continue;
+    if (used + (count + 7) / 8 > WOZ_SIZE) return 0;                            // too many tracks
+    source[track] = bits;
+    woz.offset[track] = used;
+    woz.bits[track] = count;
+    used += (count + 7) / 8;
+  }
+  for (int quarter = 0; quarter < 160; quarter++)                               // no bits, no track
+    if (woz.tmap[quarter] >= tracks || !woz.bits[woz.tmap[quarter]])
+      woz.tmap[quarter] = 0xFF;
+
+  for (int track = 0; track < tracks; track++)
+    if (woz.bits[track])
+      memcpy(unit[drive].data + woz.offset[track], source[track], (woz.bits[track] + 7) / 8);
+  woz.track = 0xFF;
+  woz.clock = cpu->ticks * 8;
+  unit[drive].woz = woz;
+  return 1;
+}
+
+
+void Disk::sequence(int drive) {
+  Woz* w = &unit[drive].woz;
+  uint32_t size = 0;
+  for (int track = 0; track < 160; track++)
+    if (w->bits[track] && w->offset[track] + (w->bits[track] + 7) / 8 > size)
+      size = w->offset[track] + (w->bits[track] + 7) / 8;
+  latches[drive].assign(size * 8, 0);
+
+  for (int track = 0; track < 160; track++) {
+    const uint8_t* bits = unit[drive].data + w->offset[track];
+    uint8_t* latch = latches[drive].data() + w->offset[track] * 8;
+    uint8_t shift = 0, complete = 0, hold = 0;
+    for (uint32_t cell = 0; cell < 2 * w->bits[track]; cell++) {                // twice around, the first one to sync
+      uint32_t position = cell < w->bits[track] ? cell : cell - w->bits[track];
+      shift = shift << 1 | ((bits[position >> 3] >> (~position & 7)) & 1);
+      if (shift & 0x80) {
+        complete = shift;
+        shift = 0;
+        hold = 2;
+      } else if (hold) {
+        hold--;
+      }
+      latch[position] = hold ? complete : shift;
+    }
+  }
+  memcpy(latchesPath[drive], unit[drive].pathName, sizeof(latchesPath[drive]));
+  memcpy(latchesBits[drive], w->bits, sizeof(latchesBits[drive]));
+}
+
+
+// .nib and sector images turn at 32 cycles per nibble. A nibble is complete in
+// the data latch for two bit cells, then the bits of the next one shift in. In
+// accelerated mode a read that would find the latch incomplete turns the floppy
+// to the next nibble at once instead : the RWTS gets every nibble at the first
+// try and the polling loop never runs. cpu->ticks is left alone, so the beam,
+// the speaker, the paddles, the journal and the rewind keep the time of the cpu.
+// Writes go to the nibble after the previous one, as the RWTS write loops are
+// not exactly 32 cycles.
+
+void Disk::spin() {
+  Drive* d = &unit[curDrv];
+  if (cpu->ticks < d->clock) d->clock = cpu->ticks;                             // an older state was restored
+  unsigned long long int nibbles = (cpu->ticks - d->clock) >> 5;
+  if (nibbles) {
+    d->clock += nibbles << 5;
+    d->nibble = (d->nibble + nibbles % 0x1A00) % 0x1A00;
+  }
+}
+
+
+uint8_t Disk::readNib() {
+  spin();
+  Drive* d = &unit[curDrv];
+  const uint8_t* track = d->data + d->track * 0x1A00;
+  unsigned int cycle = (unsigned int)(cpu->ticks - d->clock);                   // since the nibble was complete
+  if (cycle < 8)
+    return track[d->nibble];
+  if (accelerated) {                                                            // the next one, right now
+    d->nibble = (d->nibble + 1) % 0x1A00;
+    d->clock = cpu->ticks;
+    return track[d->nibble];
+  }
+  return track[(d->nibble + 1) % 0x1A00] >> (8 - cycle / 4);                     // its first bits, MSB clear
+}
+
+
+void Disk::writeNib(uint8_t value) {                                            // the latch paces the writes
+  Drive* d = &unit[curDrv];
+  if (cpu->ticks < d->clock) d->clock = cpu->ticks;
+  unsigned long long int nibbles = (cpu->ticks - d->clock + 16) >> 5;           // nearest one, 40 cycles syncs included
+  d->nibble = (d->nibble + nibbles % 0x1A00) % 0x1A00;
+  d->clock = cpu->ticks;
+  d->data[d->track * 0x1A00 + d->nibble] = value;
+  d->dirty[d->track] = true;                                                    // to be denibblelized on save
+}
+
+
+uint8_t Disk::readWoz() {
+  Woz* w = &unit[curDrv].woz;
+  unsigned long long int now = cpu->ticks * 8;
+  unsigned long long int clock = now < w->clock ? now : w->clock;
+
+  uint8_t track = w->tmap[quarterTrack[curDrv]];
+  uint32_t count = track == 0xFF ? 0 : w->bits[track];
+  if (!count) {                                                                 // unformatted, random bits
+    w->clock = now;
+    return (uint8_t)((now * 0x9E3779B97F4A7C15ULL) >> 56);
+  }
+  uint32_t position = w->position;
+  if (track != w->track) {                                                      // same angle on the new track
+    if (w->track != 0xFF && w->bits[w->track])
+      position = (uint64_t)position * count / w->bits[w->track];
+    position %= count;
+    w->track = track;
+  }
+
+  unsigned long long int elapsed = now - clock;
+  if (elapsed >= w->timing) {                                                   // bit cells since the last access
+    unsigned long long int cells = w->timing == 32 ? elapsed >> 5 : elapsed / w->timing;  // 4 us, no division
+    clock += cells * w->timing;
+    position += (uint32_t)(cells < count ? cells : cells % count);
+    if (position >= count) position -= count;
+  }
+  w->clock = clock;
+  w->position = position;
+  return latches[curDrv][w->offset[track] * 8 + position];
+}
+
+
 int Disk::load( char *path, int drive) {
   FILE *f = fopen(path, "rb");                                                  // open file in read binary mode
+  if (!f) return 0;
 
-  if (!f || fread(unit[drive].data, 1, 232960, f) != 232960)                    // load it into memory and check size
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (size <= 0 || size > (16 << 20)) {
+    fclose(f);
     return 0;
+  }
+  std::vector<uint8_t> file(size);
+  bool complete = fread(file.data(), 1, size, f) == (size_t)size;               // load it into memory and check size
   fclose(f);
+  if (!complete) return 0;
+
+  if (size >= 4 && !memcmp(file.data(), "WOZ", 3)) {
+    if (!loadWoz(file.data(), size, drive)) return 0;
+    unit[drive].format = IMG_WOZ;
+  } else if (size == NIB_SIZE) {
+    memcpy(unit[drive].data, file.data(), NIB_SIZE);
+    unit[drive].format = IMG_NIB;
+  } else if (size == DSK_SIZE) {                                                // sector image, nibblelize it
+    memcpy(unit[drive].sectors, file.data(), DSK_SIZE);
+    unit[drive].format = sectorOrder(path);
+    nibblize(unit[drive].sectors, unit[drive].data, unit[drive].format);
+  } else {
+    return 0;
+  }
+  memset(unit[drive].dirty, 0, sizeof(unit[drive].dirty));
+  unit[drive].nibble = 0;                                                       // a new floppy always starts at the same place
+  unit[drive].clock = cpu->ticks;
 
   sprintf(unit[drive].pathName, "%s", path);                                    // update floppy image pathName record
+  if (unit[drive].format == IMG_WOZ)
+    sequence(drive);
 
   // get filename
   int i =0, a = 0;
@@ -58,67 +452,116 @@ int Disk::load( char *path, int drive) {
   } else {
     unit[drive].readOnly = true;                                                // f is NULL, no writable, no need to close it
   }
+  if (unit[drive].format == IMG_WOZ)                                            // bit streams can't be written
+    unit[drive].readOnly = true;
   return 1;
 }
 
 
+int Disk::readSectors(int drive) {
+  FILE *f = fopen(unit[drive].pathName, "rb");
+  if (!f) return 0;
+  bool complete = fread(unit[drive].sectors, 1, DSK_SIZE, f) == DSK_SIZE && fgetc(f) == EOF;
+  fclose(f);
+  return complete;
+}
+
+
+static void keepAttributes(const std::filesystem::path& from, const std::filesystem::path& to) {
+  std::error_code error;                                                        // mode and owner, best effort :
+  std::filesystem::file_status status = std::filesystem::status(from, error);   // the save goes on without them
+  if (error) return;                                                            // gone meanwhile, a new file then
+  std::filesystem::permissions(to, status.permissions(), error);
+#ifndef _WIN32
+  struct stat st;
+  if (stat(from.string().c_str(), &st)) return;
+  if (chown(to.string().c_str(), st.st_uid, st.st_gid))                         // not ours to give away,
+    if (chown(to.string().c_str(), -1, st.st_gid)) return;                      // the group may still be
+#endif
+}
+
+
 int Disk::save(int drive) {
   if (!unit[drive].pathName[0]) return 0;                                       // no file loaded into drive
   if (unit[drive].readOnly) return 0;                                           // file is read only write no aptempted
+  if (unit[drive].format == IMG_WOZ) return 0;
 
-  FILE *f = fopen(unit[drive].pathName, "wb");
+  bool written = false;
+  for (int track = 0; track < 35; track++)
+    written = written || unit[drive].dirty[track];
+  if (!written) return 1;                                                       // the file is up to date
 
+  const uint8_t* image = unit[drive].data;
+  size_t size = NIB_SIZE;
+  if (unit[drive].format != IMG_NIB) {                                          // sector image, decode the tracks written to
+    for (int track = 0; track < 35; track++)
+      if (unit[drive].dirty[track] && !denibblize(unit[drive].data, unit[drive].sectors, unit[drive].format, track))
+        return 0;                                                               // a sector can't be read back, keep the file
+    image = unit[drive].sectors;
+    size = DSK_SIZE;
+  }
+
+  std::error_code error;
+  std::filesystem::path target = std::filesystem::weakly_canonical(unit[drive].pathName, error);
+  if (error) return 0;                                                          // the file behind any link, not the link
+  std::filesystem::path temp = target;                                          // written next to it, then renamed over it
+  temp += ".tmp";                                                               // so a failed save leaves the file as it was
+  FILE *f = fopen(temp.string().c_str(), "wb");
   if (!f) return 0;                                                             // could not open the file in write overide binary
-  if (fwrite(unit[drive].data, 1, 232960, f) != 232960) {                       // failed to write the full file (hdd full ?)
-    fclose(f);                                                                  // release the ressource
+  bool ok = fwrite(image, 1, size, f) == size;                                  // failed to write the full file (hdd full ?)
+  ok = fclose(f) == 0 && ok;
+  if (ok) keepAttributes(target, temp);
+  if (ok) std::filesystem::rename(temp, target, error);                         // replaces it, on Windows too
+  if (!ok || error) {
+    remove(temp.string().c_str());
     return 0;
   }
-  fclose(f);                                                                    // success, release the ressource
+  memset(unit[drive].dirty, 0, sizeof(unit[drive].dirty));
   return 1;
 }
 
 
+int Disk::flush() {                                                             // autosave
+  int ok = 1;
+  for (int drive = 0; drive < 2; drive++)
+    if (unit[drive].pathName[0] && !unit[drive].readOnly && unit[drive].format != IMG_WOZ
+        && !unit[drive].motorOn)                                                // not in the middle of a write
+      ok = save(drive) && ok;
+  return ok;
+}
+
+
 int Disk::eject(int drive)   {
   unit[drive].fileName[0] = 0;
   unit[drive].pathName[0] = 0;
   unit[drive].readOnly = false;
+  unit[drive].format = IMG_NIB;
 
-  for (int i=0; i<232960; i++)  // erase data
+  for (int i=0; i<WOZ_SIZE; i++)  // erase data
     unit[drive].data[i]=0;
 
   return 1;
 }
 
 
-void Disk::stepMotor(uint16_t address) {
-  static bool phases[2][4] = { 0 };                                             // phases states (for both drives)
-  static bool phasesB[2][4] = { 0 };                                            // phases states Before
-  static bool phasesBB[2][4] = { 0 };                                           // phases states Before Before
-  static int pIdx[2] = { 0 };                                                   // phase index (for both drives)
-  static int pIdxB[2] = { 0 };                                                  // phase index Before
-  static int halfTrackPos[2] = { 0 };
-
+void Disk::stepMotor(uint16_t address) {                                        // the head follows the magnets
+  static const int8_t pull[9] = { 5, 4, 3, 6, -1, 2, 7, 0, 1 };                 // quarter track mod 8 they hold it at
   address &= 7;
-  int phase = address >> 1;
+  phases[curDrv][address >> 1] = address & 1;
 
-  phasesBB[curDrv][pIdxB[curDrv]] = phasesB[curDrv][pIdxB[curDrv]];
-  phasesB[curDrv][pIdx[curDrv]]   = phases[curDrv][pIdx[curDrv]];
-  pIdxB[curDrv] = pIdx[curDrv];
-  pIdx[curDrv]  = phase;
+  int x = phases[curDrv][0] - phases[curDrv][2];                                // opposite phases cancel each other
+  int y = phases[curDrv][1] - phases[curDrv][3];                                // adjacent ones hold it in between
+  int target = pull[(x + 1) * 3 + y + 1];
+  if (target < 0) return;
 
-  if (!(address & 1)) {                                                         // head not moving (PHASE x OFF)
-    phases[curDrv][phase] = false;
-    return;
-  }
+  int delta = (target - quarterTrack[curDrv]) & 7;                              // nearest position, none if right opposite
+  if (delta == 4) return;
+  quarterTrack[curDrv] += delta < 4 ? delta : delta - 8;
+  if (quarterTrack[curDrv] < 0) quarterTrack[curDrv] = 0;
+  if (quarterTrack[curDrv] > 159) quarterTrack[curDrv] = 159;
 
-  if ((phasesBB[curDrv][(phase + 1) & 3]) && (--halfTrackPos[curDrv] < 0))      // head is moving in
-    halfTrackPos[curDrv] = 0;
-
-  if ((phasesBB[curDrv][(phase - 1) & 3]) && (++halfTrackPos[curDrv] > 140))    // head is moving out
-    halfTrackPos[curDrv] = 140;
-
-  phases[curDrv][phase] = true;                                                 // update track#
-  unit[curDrv].track = (halfTrackPos[curDrv] + 1) / 2;
+  int track = (quarterTrack[curDrv] + 2) / 4;                                   // update track#, nearest one
+  unit[curDrv].track = track < 34 ? track : 34;
 }
 
 
@@ -127,3 +570,82 @@ void Disk::setDrv(int drv) {
   unit[!drv].motorOn = false;                                                   // motor of the other drive is set to OFF
   curDrv = drv;                                                                 // set the current drive
 }
+
+
+void Disk::saveState(State* s) {                                                // drives and their floppies, changes included
+  s->begin("DISK");
+  s->put(curDrv);
+  for (int drv = 0; drv < 2; drv++) {
+    s->put(unit[drv].fileName, sizeof(unit[drv].fileName));
+    s->put(unit[drv].pathName, sizeof(unit[drv].pathName));
+    s->put((uint8_t)unit[drv].readOnly);
+    s->put(unit[drv].data, sizeof(unit[drv].data));
+    s->put((uint8_t)unit[drv].motorOn);
+    s->put((uint8_t)unit[drv].writeMode);
+    s->put(unit[drv].track);
+    s->put(unit[drv].nibble);
+    s->put(unit[drv].clock);
+    s->put(unit[drv].format);
+    s->put(unit[drv].woz);
+    s->put(unit[drv].dirty, sizeof(unit[drv].dirty));
+  }
+  s->put(phases);
+  s->put(quarterTrack);
+  s->end();
+}
+
+
+void Disk::loadState(State* s) {
+  uint8_t flag;
+  std::vector<uint8_t> mounted(35 * 0x1A00);
+  s->open("DISK");
+  s->get(curDrv);
+  curDrv &= 1;
+  for (int drv = 0; drv < 2; drv++) {
+    std::string path = unit[drv].pathName;                                      // the floppy being replaced
+    int format = unit[drv].format;
+    bool dirty[35];
+    memcpy(mounted.data(), unit[drv].data, mounted.size());
+    memcpy(dirty, unit[drv].dirty, sizeof(dirty));
+    s->get(unit[drv].fileName, sizeof(unit[drv].fileName));
+    s->get(unit[drv].pathName, sizeof(unit[drv].pathName));
+    unit[drv].fileName[sizeof(unit[drv].fileName) - 1] = 0;
+    unit[drv].pathName[sizeof(unit[drv].pathName) - 1] = 0;
+    s->get(flag); unit[drv].readOnly = flag != 0;
+    s->get(unit[drv].data, sizeof(unit[drv].data));
+    s->get(flag); unit[drv].motorOn = flag != 0;
+    s->get(flag); unit[drv].writeMode = flag != 0;
+    s->get(unit[drv].track);
+    s->get(unit[drv].nibble);
+    unit[drv].nibble %= 0x1A00;
+    s->get(unit[drv].clock);
+    s->get(unit[drv].format);
+    s->get(unit[drv].woz);
+    if (unit[drv].format > IMG_WOZ) unit[drv].format = IMG_NIB;
+    if (!unit[drv].woz.timing) unit[drv].woz.timing = 32;
+    for (int track = 0; track < 160; track++) {                                 // bits within data
+      if (unit[drv].woz.offset[track] + (unit[drv].woz.bits[track] + 7ULL) / 8 > WOZ_SIZE)
+        unit[drv].woz.bits[track] = 0;
+      if (unit[drv].woz.tmap[track] >= 160) unit[drv].woz.tmap[track] = 0xFF;
+    }
+    if (unit[drv].woz.track >= 160) unit[drv].woz.track = 0xFF;
+    if (unit[drv].woz.track != 0xFF && unit[drv].woz.position >= unit[drv].woz.bits[unit[drv].woz.track])
+      unit[drv].woz.position = 0;
+    if (unit[drv].format == IMG_WOZ && (strcmp(latchesPath[drv], unit[drv].pathName)
+        || memcmp(latchesBits[drv], unit[drv].woz.bits, sizeof(latchesBits[drv]))))
+      sequence(drv);                                                            // not the image sequenced last
+    s->get(unit[drv].dirty, sizeof(unit[drv].dirty));
+    if (unit[drv].format != IMG_WOZ && path == unit[drv].pathName && format == unit[drv].format) {
+      for (int track = 0; track < 35; track++)                                  // same floppy, the file has the mounted tracks
+        if (dirty[track] || memcmp(mounted.data() + track * 0x1A00, unit[drv].data + track * 0x1A00, 0x1A00))
+          unit[drv].dirty[track] = true;
+    } else if ((unit[drv].format == IMG_DOS || unit[drv].format == IMG_PRODOS) && !readSectors(drv)) {
+      memset(unit[drv].dirty, true, sizeof(unit[drv].dirty));                   // sectors of another floppy
+    }
+  }
+  s->get(phases);
+  s->get(quarterTrack);
+  for (int drv = 0; drv < 2; drv++)
+    if (quarterTrack[drv] < 0 || quarterTrack[drv] > 159) quarterTrack[drv] = 0;
+  s->close();
+}
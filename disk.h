@@ -26,15 +26,40 @@
 #ifndef __DISK_H__
 #define __DISK_H__
 
+#include <vector>
+
+#define NIB_SIZE 232960                                                         // 35 tracks of 0x1A00 nibbles
+#define DSK_SIZE 143360                                                         // 35 tracks of 16 sectors of 256 bytes
+#define WOZ_SIZE 266240                                                         // bit streams of up to 40 WOZ tracks
+#define DISK_BURST 1275000                                                      // extra cycles per frame while the motor spins
+#define AUTOSAVE   5                                                            // seconds between two saves of the floppies
+
+enum { IMG_NIB, IMG_DOS, IMG_PRODOS, IMG_WOZ };                                 // .nib, .dsk/.do, .po and .woz floppy images
+
+typedef struct Woz_t {                                                          // WOZ 1.0 and 2.0 images, bits stored in Drive::data
+  uint8_t  tmap[160];                                                           // track under each quarter track position, 0xFF if none
+  uint32_t offset[160];                                                         // of each track in data
+  uint32_t bits[160];                                                           // length of each track
+  uint8_t  timing;                                                              // bit cell, in 125 ns units (32 for 4 us)
+  uint8_t  track;                                                               // track under the head
+  uint32_t position;                                                            // bit under the head
+  unsigned long long int clock;                                                 // cpu->ticks * 8 when it got there
+} Woz;
+
 typedef struct Drive_t {
   char     fileName[400];                                                       // the floppy image file name
   char     pathName[400];                                                       // the full floppy image path name
   bool     readOnly;                                                            // based on the image file attributes
-  uint8_t  data[232960];                                                        // nibblelized floppy image
+  uint8_t  data[WOZ_SIZE];                                                      // nibblelized floppy image, or WOZ bit streams
+  uint8_t  format;                                                              // IMG_NIB, IMG_WOZ, or the sector order of the image file
+  Woz      woz;
+  uint8_t  sectors[DSK_SIZE];                                                   // sector image as loaded or last saved
+  bool     dirty[35];                                                           // tracks written since then
   bool     motorOn;                                                             // motor status
-  bool     writeMode;                                                           // writes to file are not implemented
+  bool     writeMode;                                                           // data latch shifts to the floppy
   uint8_t  track;                                                               // current track position
   uint16_t nibble;                                                              // ptr to nibble under head position
+  unsigned long long int clock;                                                 // cpu->ticks when it got there
 } Drive;
 
 
@@ -42,16 +67,41 @@ class Disk {
 public:
   int curDrv = 0;                                                               // Current Drive - only one can be enabled at a time
   Drive unit[2] = {0};                                                          // two disk ][ drive units
+  bool accelerated = true;                                                      // skip the polling of $C0EC, burst while spinning
+  bool autosave = false;                                                        // flush() every AUTOSAVE seconds
+
+  bool phases[2][4] = { 0 };                                                    // phases states (for both drives)
+  int quarterTrack[2] = { 0 };                                                  // head position (for both drives)
 
   Disk();
   ~Disk();
 
   int load(char *filename, int drv);
-  int save(int drive);
+  int save(int drive);                                                          // the tracks written to, atomically
+  int flush();                                                                  // saves the idle floppies written to
   int eject(int drive);
 
+  static void nibblize(const uint8_t* image, uint8_t* nibbles, int format);     // no drive involved, safe from any thread
+  static bool denibblize(const uint8_t* nibbles, uint8_t* image, int format, int track);
+  uint8_t readNib();                                                            // $C0EC, the nibble under the head
+  void writeNib(uint8_t value);
+  uint8_t readWoz();                                                            // $C0EC, the bits that went under the head
+
   void setDrv(int drv);
   void stepMotor(uint16_t address);
+
+  void saveState(State* state);
+  void loadState(State* state);
+
+private:
+  std::vector<uint8_t> latches[2];                                              // WOZ : data latch at each bit cell
+  char latchesPath[2][400] = { 0 };                                             // of this image
+  uint32_t latchesBits[2][160] = { 0 };
+
+  int loadWoz(const uint8_t* file, size_t size, int drive);
+  int readSectors(int drive);                                                   // sectors as they are in the file
+  void sequence(int drive);                                                     // fills latches
+  void spin();                                                                  // nibble under the head at cpu->ticks
 };
 
 #endif
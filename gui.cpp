@@ -25,10 +25,21 @@
 
 #include "reinette.h"
 
+static void createTexture(uint32_t* texture, int width, int height, const uint32_t* pixels) {
+  glGenTextures(1, texture);
+  glBindTexture(GL_TEXTURE_2D, *texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
+
 Gui::Gui() {
-  frameNumber = 0;
   screenScale = 2.0f;
-  fps = 60;
+  core->latest(&frame);                                                         // an empty one until the core runs
+  freshFrame = false;
+  uploadedMode = video->gfxmode;
+  memset(buttons, 0, sizeof(buttons));
 
   show_about_window    = false;
   show_help_window     = false;
@@ -47,6 +58,8 @@ Gui::Gui() {
   show_editor_window   = true;
   show_ramHeatmap_window = true;
   show_auxHeatmap_window = true;
+  show_trace_window    = true;
+  show_library_window  = true;
 
   // Setup SDL
   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) != 0) {
@@ -83,9 +96,14 @@ Gui::Gui() {
   ImGui_ImplOpenGL2_Init();
 
   clear_color = ImVec4((float)51/256, (float)58/256, (float)64/256, 1.00f);     // fond de la fenetre principale
-  glGenTextures(1, &screenTexture);
-  glGenTextures(1, &ramHeatmapTexture);
-  glGenTextures(1, &auxHeatmapTexture);
+  createTexture(&screenTexture,     280, 192, video->screenPixels);             // textures are allocated once,
+  createTexture(&screenTexture80,   560, 384, video->screenPixels80);           // then only updated
+  createTexture(&ramHeatmapTexture, 256, 256, NULL);
+  createTexture(&auxHeatmapTexture, 256, 256, NULL);
+#ifdef PBO
+  glGenBuffers(2, pixelBuffers);
+  pixelBuffer = 0;
+#endif
 
   // editor init
   auto lang = TextEditor::LanguageDefinition::AppleSoft();
@@ -112,72 +130,153 @@ int Gui::newFrame() {
 
 
 
+//================================================== RUN ON THE CORE THREAD
+
+static void typeText(const std::string& text, int cycles) {                     // types text, as if pasted
+  for (char c : text) {                                                         // all chars until ascii NUL
+    mmu->KBD = c | 0x80;                                                        // set bit7
+    if (mmu->KBD == 0x8A) mmu->KBD = 0x8D;                                      // translate Line Feed to Carriage Ret
+    journal->input(J_KEY, 0, mmu->KBD);
+    cpu->exec(cycles);                                                          // give cpu (and applesoft) some cycles to process each char
+  }
+}
+
+
+static void toggleRecording() {                                                 // inputs journal
+  if (!journal->recording)
+    journal->start();
+  else if (!journal->stop(JOURNAL_FILE))
+    core->message = "Could not write " JOURNAL_FILE;
+}
+
+
+static void stopRecording() {                                                   // the journal ends where time jumps
+  if (journal->recording) toggleRecording();
+}
+
+
+static void pressKey(uint8_t key) {
+  mmu->KBD = key;
+  journal->input(J_KEY, 0, key);
+}
+
+
+static void insertFloppy(const std::string& path, int drive, bool coldReset) {
+  if (!disk->load((char*)path.c_str(), drive)) {
+    core->message = "Not a valid floppy image";
+    return;
+  }
+  paused = false;                                                               // might already be the case
+  if (coldReset) {
+    mmu->init();
+    mmu->writeMem(0x3F4,0);                                                     // unset the Power-UP byte
+    cpu->RST();                                                                 // do a cold reset
+  }
+}
+
+
+//=================================================================== LIBRARY
+
+static std::string lowered(const char* text) {
+  std::string lower = text;
+  for (char& c : lower) c = tolower(c);
+  return lower;
+}
+
+
+static bool matches(const Title& title, const std::string& text) {              // text is lowercase
+  if (text.empty()) return true;
+  if (lowered(title.path.c_str()).find(text) != std::string::npos
+      || lowered(title.volume.c_str()).find(text) != std::string::npos)
+    return true;
+  for (const std::string& file : title.files)
+    if (lowered(file.c_str()).find(text) != std::string::npos) return true;
+  return false;
+}
+
+
+
 void Gui::getInputs() {
 
   SDL_Event event;
   while (SDL_PollEvent(&event)) {
     ImGui_ImplSDL2_ProcessEvent(&event);
+    int typedKey = -1;                                                          // Apple II code of the key pressed
 
     SDL_bool ctrl, shift, alt;
 
     alt = SDL_GetModState() & KMOD_ALT   ? SDL_TRUE : SDL_FALSE;
     ctrl = SDL_GetModState() & KMOD_CTRL  ? SDL_TRUE : SDL_FALSE;
     shift = SDL_GetModState() & KMOD_SHIFT ? SDL_TRUE : SDL_FALSE;
-    paddles->PB0 = alt   ? 0xFF : 0x00;                                         // update push button 0, Open Apple
-    paddles->PB1 = ctrl  ? 0xFF : 0x00;                                         // update push button 1, Solid Apple or option
-    paddles->PB2 = shift ? 0xFF : 0x00;                                         // update push button 2, single-wire Shift-key mod
+    uint8_t pb[3] = { (uint8_t)(alt   ? 0xFF : 0x00),                           // push button 0, Open Apple
+                      (uint8_t)(ctrl  ? 0xFF : 0x00),                           // push button 1, Solid Apple or option
+                      (uint8_t)(shift ? 0xFF : 0x00) };                         // push button 2, single-wire Shift-key mod
+    if (memcmp(pb, buttons, sizeof(buttons))) {
+      memcpy(buttons, pb, sizeof(buttons));
+      core->post([pb0 = pb[0], pb1 = pb[1], pb2 = pb[2]] { paddles->PB0 = pb0; paddles->PB1 = pb1; paddles->PB2 = pb2; });
+    }
 
 
     if (event.type == SDL_QUIT) running = false;                                // WM sent TERM signal
 
     if (event.type == SDL_DROPFILE) {                                           // user dropped a file
-      char *filename = event.drop.file;                                         // get full pathname
-      if (!disk->load(filename, alt))                                           // if ALT : drv 1 else drv 0
-        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Load", "Not a valid nib file", NULL);
-      SDL_free(filename);                                                       // free filename memory
-      paused = false;                                                           // might already be the case
-      if (!(alt || ctrl)) {                                                     // unless ALT or CTRL were
-        mmu->init();
-        mmu->writeMem(0x3F4,0);                                                 // unset the Power-UP byte
-        cpu->RST();                                                             // do a cold reset
-      }
+      std::string filename = event.drop.file;                                   // get full pathname
+      SDL_free(event.drop.file);                                                // free filename memory
+      bool coldReset = !(alt || ctrl);                                          // unless ALT or CTRL were
+      core->post([filename, drive = (int)alt, coldReset] {                      // if ALT : drv 1 else drv 0
+        insertFloppy(filename, drive, coldReset);
+      });
     }
 
+    if (event.type == SDL_KEYUP && event.key.keysym.sym == SDLK_F9) core->scrub = 0;  // even if the focus moved
+
     if (CRT_is_focused) {      // if (!io.WantCaptureKeyboard) {
       if (event.type == SDL_KEYDOWN) {                                          // a key has been pressed
         switch (event.key.keysym.sym) {
 
         // EMULATOR CONTROLS :
 
+        case SDLK_F2:                                                           // SAVE / RESTORE STATE
+          if (shift) core->post([] {
+            stopRecording();
+            if (!(core->state->read(STATE_FILE) && core->state->restore()))
+              core->message = "Not a valid state file";
+          });
+          else core->post([] {
+            core->state->snapshot();
+            if (!core->state->write(STATE_FILE))
+              core->message = "Could not write " STATE_FILE;
+          });
+        break;
+
         case SDLK_F3:                                                           // PASTE text from clipboard
           if (SDL_HasClipboardText()) {
             char *clipboardText = SDL_GetClipboardText();
-            int c = 0;
-            while (clipboardText[c]) {                                          // all chars until ascii NUL
-              mmu->KBD = clipboardText[c++] | 0x80;                             // set bit7
-              if (mmu->KBD == 0x8A) mmu->KBD = 0x8D;                            // translate Line Feed to Carriage Ret
-              cpu->exec(400000);                                                // give cpu (and applesoft) some cycles to process each char
-            }
+            core->post([text = std::string(clipboardText)] { typeText(text, 400000); });
             SDL_free(clipboardText);                                            // release the ressource
           }
         break;
 
         case SDLK_F4:                                                           // VOLUME
-          if (shift) speaker->setVolume(volume+10);                             // increase volume
-          if (ctrl)  speaker->setVolume(volume-10);                             // decrease volume
-          if (!ctrl && !shift) speaker->toggleMute();                           // toggle mute / unmute
+          if (shift) core->post([] { speaker->setVolume(volume+10); });         // increase volume
+          if (ctrl)  core->post([] { speaker->setVolume(volume-10); });         // decrease volume
+          if (!ctrl && !shift) core->post([] { speaker->toggleMute(); });       // toggle mute / unmute
         break;
 
         case SDLK_F5:                                                           // JOYSTICK Release Speed
-          if (shift && (paddles->GCReleaseSpeed < 127)) paddles->GCReleaseSpeed += 2;  // increase Release Speed
-          if (ctrl && (paddles->GCReleaseSpeed > 1)) paddles->GCReleaseSpeed -= 2;     // decrease Release Speed
-          if (!ctrl && !shift) paddles->GCReleaseSpeed = 8;                     // reset Release Speed to 8
+          core->post([shift, ctrl] {
+            if (shift && (paddles->GCReleaseSpeed < 127)) paddles->GCReleaseSpeed += 2;  // increase Release Speed
+            if (ctrl && (paddles->GCReleaseSpeed > 1)) paddles->GCReleaseSpeed -= 2;     // decrease Release Speed
+            if (!ctrl && !shift) paddles->GCReleaseSpeed = 8;                   // reset Release Speed to 8
+          });
           break;
 
         case SDLK_F6:                                                           // JOYSTICK Action Speed
-          if (shift && (paddles->GCActionSpeed < 127)) paddles->GCActionSpeed += 2;  // increase Action Speed
-          if (ctrl && (paddles->GCActionSpeed > 1)) paddles->GCActionSpeed -= 2;     // decrease Action Speed
-          if (!ctrl && !shift) paddles->GCActionSpeed = 8;                      // reset Action Speed to 8
+          core->post([shift, ctrl] {
+            if (shift && (paddles->GCActionSpeed < 127)) paddles->GCActionSpeed += 2;  // increase Action Speed
+            if (ctrl && (paddles->GCActionSpeed > 1)) paddles->GCActionSpeed -= 2;     // decrease Action Speed
+            if (!ctrl && !shift) paddles->GCActionSpeed = 8;                    // reset Action Speed to 8
+          });
           break;
 
         case SDLK_F7:                                                           // ZOOM
@@ -186,99 +285,136 @@ void Gui::getInputs() {
           if (!ctrl && !shift) screenScale = 2.0f;                              // reset zoom to 2
         break;
 
-        case SDLK_F10: paused = !paused; break;                                 // toggle pause
+        case SDLK_F8: core->post(toggleRecording); break;                       // RECORD the inputs journal
 
-        case SDLK_F11:  {
-          paused = true;
-          cpu->state = step;
-        } break;
+        case SDLK_F9:                                                           // REWIND while held, forward with shift
+          core->post(stopRecording);
+          core->scrub = shift ? 1 : -1;
+        break;
 
-        case SDLK_F12: cpu->RST(); break;                                       // reset
+        case SDLK_F10: core->post([] { paused = !paused; }); break;             // toggle pause
+
+        case SDLK_F11:
+          core->post([] {
+            paused = true;
+            cpu->state = step;
+          });
+        break;
+
+        case SDLK_F12: core->post([] { cpu->RST(); journal->input(J_RESET); }); break;  // reset
 
         // EMULATED KEYS :
 
-        case SDLK_a:            mmu->KBD = ctrl ? 0x81: 0xC1;   break;          // a
-        case SDLK_b:            mmu->KBD = ctrl ? 0x82: 0xC2;   break;          // b STX
-        case SDLK_c:            mmu->KBD = ctrl ? 0x83: 0xC3;   break;          // c ETX
-        case SDLK_d:            mmu->KBD = ctrl ? 0x84: 0xC4;   break;          // d EOT
-        case SDLK_e:            mmu->KBD = ctrl ? 0x85: 0xC5;   break;          // e
-        case SDLK_f:            mmu->KBD = ctrl ? 0x86: 0xC6;   break;          // f ACK
-        case SDLK_g:            mmu->KBD = ctrl ? 0x87: 0xC7;   break;          // g BELL
-        case SDLK_h:            mmu->KBD = ctrl ? 0x88: 0xC8;   break;          // h BS
-        case SDLK_i:            mmu->KBD = ctrl ? 0x89: 0xC9;   break;          // i HTAB
-        case SDLK_j:            mmu->KBD = ctrl ? 0x8A: 0xCA;   break;          // j LF
-        case SDLK_k:            mmu->KBD = ctrl ? 0x8B: 0xCB;   break;          // k VTAB
-        case SDLK_l:            mmu->KBD = ctrl ? 0x8C: 0xCC;   break;          // l FF
-        case SDLK_m:            mmu->KBD = ctrl ? shift ? 0x9D:0x8D:0xCD; break;// m CR ]
-        case SDLK_n:            mmu->KBD = ctrl ? shift ? 0x9E:0x8E:0xCE; break;// n ^
-        case SDLK_o:            mmu->KBD = ctrl ? 0x8F: 0xCF;   break;          // o
-        case SDLK_p:            mmu->KBD = ctrl ? shift ? 0x80:0x90:0xD0; break;     // p @
-        case SDLK_q:            mmu->KBD = ctrl ? 0x91: 0xD1;   break;          // q
-        case SDLK_r:            mmu->KBD = ctrl ? 0x92: 0xD2;   break;          // r
-        case SDLK_s:            mmu->KBD = ctrl ? 0x93: 0xD3;   break;          // s ESC
-        case SDLK_t:            mmu->KBD = ctrl ? 0x94: 0xD4;   break;          // t
-        case SDLK_u:            mmu->KBD = ctrl ? 0x95: 0xD5;   break;          // u NAK
-        case SDLK_v:            mmu->KBD = ctrl ? 0x96: 0xD6;   break;          // v
-        case SDLK_w:            mmu->KBD = ctrl ? 0x97: 0xD7;   break;          // w
-        case SDLK_x:            mmu->KBD = ctrl ? 0x98: 0xD8;   break;          // x CANCEL
-        case SDLK_y:            mmu->KBD = ctrl ? 0x99: 0xD9;   break;          // y
-        case SDLK_z:            mmu->KBD = ctrl ? 0x9A: 0xDA;   break;          // z
-        case SDLK_LEFTBRACKET:  mmu->KBD = ctrl ? 0x9B: 0xDB;   break;          // [ {
-        case SDLK_BACKSLASH:    mmu->KBD = ctrl ? 0x9C: 0xDC;   break;          // \ |
-        case SDLK_RIGHTBRACKET: mmu->KBD = ctrl ? 0x9D: 0xDD;   break;          // ] }
-        case SDLK_BACKSPACE:    mmu->KBD = ctrl ? 0xDF: 0x88;   break;          // BS
-        case SDLK_0:            mmu->KBD = shift? 0xA9: 0xB0;   break;          // 0 )
-        case SDLK_1:            mmu->KBD = shift? 0xA1: 0xB1;   break;          // 1 !
-        case SDLK_2:            mmu->KBD = shift? 0xC0: 0xB2;   break;          // 2
-        case SDLK_3:            mmu->KBD = shift? 0xA3: 0xB3;   break;          // 3 #
-        case SDLK_4:            mmu->KBD = shift? 0xA4: 0xB4;   break;          // 4 $
-        case SDLK_5:            mmu->KBD = shift? 0xA5: 0xB5;   break;          // 5 %
-        case SDLK_6:            mmu->KBD = shift? 0xDE: 0xB6;   break;          // 6 ^
-        case SDLK_7:            mmu->KBD = shift? 0xA6: 0xB7;   break;          // 7 &
-        case SDLK_8:            mmu->KBD = shift? 0xAA: 0xB8;   break;          // 8 *
-        case SDLK_9:            mmu->KBD = shift? 0xA8: 0xB9;   break;          // 9 (
-        case SDLK_QUOTE:        mmu->KBD = shift? 0xA2: 0xA7;   break;          // ' "
-        case SDLK_EQUALS:       mmu->KBD = shift? 0xAB: 0xBD;   break;          // = +
-        case SDLK_SEMICOLON:    mmu->KBD = shift? 0xBA: 0xBB;   break;          // ; :
-        case SDLK_COMMA:        mmu->KBD = shift? 0xBC: 0xAC;   break;          // , <
-        case SDLK_PERIOD:       mmu->KBD = shift? 0xBE: 0xAE;   break;          // . >
-        case SDLK_SLASH:        mmu->KBD = shift? 0xBF: 0xAF;   break;          // / ?
-        case SDLK_MINUS:        mmu->KBD = shift? 0xDF: 0xAD;   break;          // - _
-        case SDLK_BACKQUOTE:    mmu->KBD = shift? 0xFE: 0xE0;   break;          // ` ~
-        case SDLK_LEFT:         mmu->KBD = 0x88;                break;          // BS
-        case SDLK_RIGHT:        mmu->KBD = 0x95;                break;          // NAK
-        case SDLK_DOWN:         mmu->KBD = 0x8A;                break;          // LF
-        case SDLK_UP:           mmu->KBD = 0x8B;                break;          // VTAB
-        case SDLK_SPACE:        mmu->KBD = 0xA0;                break;
-        case SDLK_ESCAPE:       mmu->KBD = 0x9B;                break;          // ESC
-        case SDLK_RETURN:       mmu->KBD = 0x8D;                break;          // CR
-        case SDLK_TAB:          mmu->KBD = 0x89;                break;          // HTAB
+        case SDLK_a:            typedKey = ctrl ? 0x81: 0xC1;   break;          // a
+        case SDLK_b:            typedKey = ctrl ? 0x82: 0xC2;   break;          // b STX
+        case SDLK_c:            typedKey = ctrl ? 0x83: 0xC3;   break;          // c ETX
+        case SDLK_d:            typedKey = ctrl ? 0x84: 0xC4;   break;          // d EOT
+        case SDLK_e:            typedKey = ctrl ? 0x85: 0xC5;   break;          // e
+        case SDLK_f:            typedKey = ctrl ? 0x86: 0xC6;   break;          // f ACK
+        case SDLK_g:            typedKey = ctrl ? 0x87: 0xC7;   break;          // g BELL
+        case SDLK_h:            typedKey = ctrl ? 0x88: 0xC8;   break;          // h BS
+        case SDLK_i:            typedKey = ctrl ? 0x89: 0xC9;   break;          // i HTAB
+        case SDLK_j:            typedKey = ctrl ? 0x8A: 0xCA;   break;          // j LF
+        case SDLK_k:            typedKey = ctrl ? 0x8B: 0xCB;   break;          // k VTAB
+        case SDLK_l:            typedKey = ctrl ? 0x8C: 0xCC;   break;          // l FF
+        case SDLK_m:            typedKey = ctrl ? shift ? 0x9D:0x8D:0xCD; break;// m CR ]
+        case SDLK_n:            typedKey = ctrl ? shift ? 0x9E:0x8E:0xCE; break;// n ^
+        case SDLK_o:            typedKey = ctrl ? 0x8F: 0xCF;   break;          // o
+        case SDLK_p:            typedKey = ctrl ? shift ? 0x80:0x90:0xD0; break;     // p @
+        case SDLK_q:            typedKey = ctrl ? 0x91: 0xD1;   break;          // q
+        case SDLK_r:            typedKey = ctrl ? 0x92: 0xD2;   break;          // r
+        case SDLK_s:            typedKey = ctrl ? 0x93: 0xD3;   break;          // s ESC
+        case SDLK_t:            typedKey = ctrl ? 0x94: 0xD4;   break;          // t
+        case SDLK_u:            typedKey = ctrl ? 0x95: 0xD5;   break;          // u NAK
+        case SDLK_v:            typedKey = ctrl ? 0x96: 0xD6;   break;          // v
+        case SDLK_w:            typedKey = ctrl ? 0x97: 0xD7;   break;          // w
+        case SDLK_x:            typedKey = ctrl ? 0x98: 0xD8;   break;          // x CANCEL
+        case SDLK_y:            typedKey = ctrl ? 0x99: 0xD9;   break;          // y
+        case SDLK_z:            typedKey = ctrl ? 0x9A: 0xDA;   break;          // z
+        case SDLK_LEFTBRACKET:  typedKey = ctrl ? 0x9B: 0xDB;   break;          // [ {
+        case SDLK_BACKSLASH:    typedKey = ctrl ? 0x9C: 0xDC;   break;          // \ |
+        case SDLK_RIGHTBRACKET: typedKey = ctrl ? 0x9D: 0xDD;   break;          // ] }
+        case SDLK_BACKSPACE:    typedKey = ctrl ? 0xDF: 0x88;   break;          // BS
+        case SDLK_0:            typedKey = shift? 0xA9: 0xB0;   break;          // 0 )
+        case SDLK_1:            typedKey = shift? 0xA1: 0xB1;   break;          // 1 !
+        case SDLK_2:            typedKey = shift? 0xC0: 0xB2;   break;          // 2
+        case SDLK_3:            typedKey = shift? 0xA3: 0xB3;   break;          // 3 #
+        case SDLK_4:            typedKey = shift? 0xA4: 0xB4;   break;          // 4 $
+        case SDLK_5:            typedKey = shift? 0xA5: 0xB5;   break;          // 5 %
+        case SDLK_6:            typedKey = shift? 0xDE: 0xB6;   break;          // 6 ^
+        case SDLK_7:            typedKey = shift? 0xA6: 0xB7;   break;          // 7 &
+        case SDLK_8:            typedKey = shift? 0xAA: 0xB8;   break;          // 8 *
+        case SDLK_9:            typedKey = shift? 0xA8: 0xB9;   break;          // 9 (
+        case SDLK_QUOTE:        typedKey = shift? 0xA2: 0xA7;   break;          // ' "
+        case SDLK_EQUALS:       typedKey = shift? 0xAB: 0xBD;   break;          // = +
+        case SDLK_SEMICOLON:    typedKey = shift? 0xBA: 0xBB;   break;          // ; :
+        case SDLK_COMMA:        typedKey = shift? 0xBC: 0xAC;   break;          // , <
+        case SDLK_PERIOD:       typedKey = shift? 0xBE: 0xAE;   break;          // . >
+        case SDLK_SLASH:        typedKey = shift? 0xBF: 0xAF;   break;          // / ?
+        case SDLK_MINUS:        typedKey = shift? 0xDF: 0xAD;   break;          // - _
+        case SDLK_BACKQUOTE:    typedKey = shift? 0xFE: 0xE0;   break;          // ` ~
+        case SDLK_LEFT:         typedKey = 0x88;                break;          // BS
+        case SDLK_RIGHT:        typedKey = 0x95;                break;          // NAK
+        case SDLK_DOWN:         typedKey = 0x8A;                break;          // LF
+        case SDLK_UP:           typedKey = 0x8B;                break;          // VTAB
+        case SDLK_SPACE:        typedKey = 0xA0;                break;
+        case SDLK_ESCAPE:       typedKey = 0x9B;                break;          // ESC
+        case SDLK_RETURN:       typedKey = 0x8D;                break;          // CR
+        case SDLK_TAB:          typedKey = 0x89;                break;          // HTAB
 
         // EMULATED JOYSTICK :
 
-        case SDLK_KP_1: paddles->GCD[0] = -1; paddles->GCA[0] = 1; break;       // pdl0 <-
-        case SDLK_KP_3: paddles->GCD[0] = 1;  paddles->GCA[0] = 1; break;       // pdl0 ->
-        case SDLK_KP_5: paddles->GCD[1] = -1; paddles->GCA[1] = 1; break;       // pdl1 <-
-        case SDLK_KP_2: paddles->GCD[1] = 1;  paddles->GCA[1] = 1; break;       // pdl1 ->
+        case SDLK_KP_1: core->post([] { paddles->GCD[0] = -1; paddles->GCA[0] = 1; }); break;  // pdl0 <-
+        case SDLK_KP_3: core->post([] { paddles->GCD[0] = 1;  paddles->GCA[0] = 1; }); break;  // pdl0 ->
+        case SDLK_KP_5: core->post([] { paddles->GCD[1] = -1; paddles->GCA[1] = 1; }); break;  // pdl1 <-
+        case SDLK_KP_2: core->post([] { paddles->GCD[1] = 1;  paddles->GCA[1] = 1; }); break;  // pdl1 ->
         }
       }
 
       if (event.type == SDL_KEYUP) {
         switch (event.key.keysym.sym) {
-        case SDLK_KP_1: paddles->GCD[0] = 1;  paddles->GCA[0] = 0; break;       // pdl0 ->
-        case SDLK_KP_3: paddles->GCD[0] = -1; paddles->GCA[0] = 0; break;       // pdl0 <-
-        case SDLK_KP_5: paddles->GCD[1] = 1;  paddles->GCA[1] = 0; break;       // pdl1 ->
-        case SDLK_KP_2: paddles->GCD[1] = -1; paddles->GCA[1] = 0; break;       // pdl1 <-
+        case SDLK_KP_1: core->post([] { paddles->GCD[0] = 1;  paddles->GCA[0] = 0; }); break;  // pdl0 ->
+        case SDLK_KP_3: core->post([] { paddles->GCD[0] = -1; paddles->GCA[0] = 0; }); break;  // pdl0 <-
+        case SDLK_KP_5: core->post([] { paddles->GCD[1] = 1;  paddles->GCA[1] = 0; }); break;  // pdl1 ->
+        case SDLK_KP_2: core->post([] { paddles->GCD[1] = -1; paddles->GCA[1] = 0; }); break;  // pdl1 <-
         }
       }
     }
+    if (typedKey >= 0) core->post([typedKey] { pressKey(typedKey); });
   }
 }
 
 
 
+static Frame* shown;                                                            // the frame the editors show
+
+static void writeRam(ImU8* data, size_t offset, ImU8 value) {                   // memory editors bypass the Mmu,
+  size_t address = data - shown->ram + offset;                                  // tell the video what they changed
+  data[offset] = value;                                                         // until the next frame comes
+  core->post([address, value] {
+    mmu->ram[address] = value;
+    mmu->videoDirty[MAIN_BANK][address >> 7] = 1;
+  });
+}
+
+
+static void writeAux(ImU8* data, size_t offset, ImU8 value) {
+  size_t address = data - shown->aux + offset;
+  data[offset] = value;
+  core->post([address, value] {
+    mmu->aux[address] = value;
+    mmu->videoDirty[AUX_BANK][address >> 7] = 1;
+  });
+}
+
 
 int Gui::update() {
+  freshFrame |= core->latest(&frame);
+  shown = frame;
+  Frame* f = frame;
+
+  const char* message = core->message.exchange(NULL);                           // an error from the core
+  if (message) SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Reinette", message, NULL);
 
   if (ImGui::BeginMainMenuBar()) {
     if (ImGui::BeginMenu("File")) {
@@ -353,13 +489,19 @@ int Gui::update() {
       ImGui::MenuItem("Main RAM", NULL, &show_ram_window);
       ImGui::MenuItem("Aux RAM", NULL, &show_aux_window);
       ImGui::MenuItem("ROM", NULL, &show_rom_window);
+#ifdef HEATMAP
       ImGui::MenuItem("RAM Heatmap", NULL, &show_ramHeatmap_window);
       ImGui::MenuItem("AUX Heatmap", NULL, &show_auxHeatmap_window);
+#endif
       ImGui::Separator();
       ImGui::MenuItem("Controls", NULL, &show_control_window);
       ImGui::MenuItem("CPU", NULL, &show_cpu_window);
       ImGui::MenuItem("Code", NULL, &show_code_window);
+#ifdef TRACE
+      ImGui::MenuItem("Trace", NULL, &show_trace_window);
+#endif
       ImGui::MenuItem("Disk", NULL, &show_disks_window);
+      ImGui::MenuItem("Library", NULL, &show_library_window);
       ImGui::MenuItem("Info", NULL, &show_info_window);
       ImGui::Separator();
       ImGui::MenuItem("Editor", NULL, &show_editor_window);
@@ -374,19 +516,25 @@ int Gui::update() {
     ImGui::EndMainMenuBar();
   }
 
+  core->ramShown = show_stack_window || show_pageZero_window || show_ram_window;
+  core->auxShown = show_aux_window;                                             // copied by the core only when shown
+
   static MemoryEditor mem_edit_stack;
+  mem_edit_stack.WriteFn = writeRam;
   if (show_stack_window) {
-    mem_edit_stack.DrawWindow("STACK", mmu->ram+256, 256);
+    mem_edit_stack.DrawWindow("STACK", f->ram+256, 256);
   }
 
   static MemoryEditor mem_edit_pageZero;
+  mem_edit_pageZero.WriteFn = writeRam;
   if (show_pageZero_window) {
-    mem_edit_pageZero.DrawWindow("PAGE ZERO", mmu->ram, 256);
+    mem_edit_pageZero.DrawWindow("PAGE ZERO", f->ram, 256);
   }
 
   static MemoryEditor mem_edit_ram;
+  mem_edit_ram.WriteFn = writeRam;
   if (show_ram_window) {
-    mem_edit_ram.DrawWindow("RAM", mmu->ram, RAMSIZE);
+    mem_edit_ram.DrawWindow("RAM", f->ram, RAMSIZE);
   }
 
   static MemoryEditor mem_edit_rom;
@@ -395,8 +543,9 @@ int Gui::update() {
   }
 
   static MemoryEditor mem_edit_aux;
+  mem_edit_aux.WriteFn = writeAux;
   if (show_aux_window) {
-    mem_edit_aux.DrawWindow("AUX", mmu->aux, AUXSIZE);
+    mem_edit_aux.DrawWindow("AUX", f->aux, AUXSIZE);
   }
 
   if (show_about_window) {
@@ -417,6 +566,9 @@ int Gui::update() {
       ImGui::Text(  "\nctrl F1      writes the changes of the floppy in drive 0"
                     "\nalt F1       writes the changes of the floppy in drive 1"
                     "\n"
+                    "\nF2           save the state of the machine to " STATE_FILE
+                    "\nshift F2     restore the state saved in " STATE_FILE
+                    "\n"
                     "\nF3           paste text from clipboard"
                     "\n"
                     "\nF4           mute / un-mute sound"
@@ -435,14 +587,18 @@ int Gui::update() {
                     "\nshift F7     increase zoom up to 4:1 max"
                     "\nctrl F7      decrease zoom down to 1:1 pixels"
                     "\n"
-                    "\nF8           monochrome / color display (only in HGR)"
-                    "\nF9           pause / un-pause the emulator"
+                    "\nF8           start / stop recording the inputs to " JOURNAL_FILE
+                    "\nF9           rewind, while held"
+                    "\nshift F9     forward again, while held"
                     "\nF10          Not implemented"
                     "\nF11          reset");
     ImGui::End();
     }
   }
 
+#ifdef HEATMAP
+  core->heatmapShown[MAIN_BANK] = show_ramHeatmap_window;                       // filled by the core only when shown
+  core->heatmapShown[AUX_BANK]  = show_auxHeatmap_window;
   if (show_ramHeatmap_window) {
     ImGui::Begin("RAM HEATMAP", &show_ramHeatmap_window);
       // Adjust the image to the window
@@ -462,35 +618,78 @@ int Gui::update() {
       ImGui::Image((void*)((intptr_t)auxHeatmapTexture), image_size, ImVec2(0,0), ImVec2(1,1), ImColor(255,255,255,255), ImColor(0,0,0,0));
     ImGui::End();
   }
+#endif
 
   if (show_control_window) {
     ImGui::Begin("CONTROLS", &show_control_window);
-      ImGui::SliderInt("GC ACTION", &paddles->GCActionSpeed, 0, 128);                    // JOYSTICK Action Speed
-      ImGui::SliderInt("GC RELEASE", &paddles->GCReleaseSpeed, 0, 128);                  // JOYSTICK Release Speed
+      int actionSpeed = f->GCActionSpeed;                                       // the widgets edit copies,
+      int releaseSpeed = f->GCReleaseSpeed;                                     // the core applies the changes
+      if (ImGui::SliderInt("GC ACTION", &actionSpeed, 0, 128))                  // JOYSTICK Action Speed
+        core->post([actionSpeed] { paddles->GCActionSpeed = actionSpeed; });
+      if (ImGui::SliderInt("GC RELEASE", &releaseSpeed, 0, 128))                // JOYSTICK Release Speed
+        core->post([releaseSpeed] { paddles->GCReleaseSpeed = releaseSpeed; });
       ImGui::Separator();
       ImGui::SliderFloat("SCALE", &screenScale, 1, 4, "%.1f");
-      if (ImGui::SliderInt("VOLUME", &volume, 0, 127)) speaker->setVolume(volume);
+      int newVolume = f->volume;
+      if (ImGui::SliderInt("VOLUME", &newVolume, 0, 127))
+        core->post([newVolume] { speaker->setVolume(newVolume); });
       ImGui::SameLine();
-      if (ImGui::Checkbox("MUTE", &muted)) speaker->toggleMute();
+      bool mute = f->muted;
+      if (ImGui::Checkbox("MUTE", &mute))
+        core->post([mute] { muted = mute; speaker->toggleMute(); });
       ImGui::Separator();
-      if (ImGui::SliderFloat("SPEED", &speed, .0f, 200, "%.4f MHz", ImGuiSliderFlags_Logarithmic));
+      float newSpeed = f->speed;
+      if (ImGui::SliderFloat("SPEED", &newSpeed, .0f, 200, "%.4f MHz", ImGuiSliderFlags_Logarithmic))
+        core->post([newSpeed] { speed = newSpeed; });
       ImGui::SameLine();
-      if (ImGui::Button("NORMAL")) speed = 1.023f;
-      ImGui::Checkbox("PAUSE", &paused);
+      if (ImGui::Button("NORMAL")) core->post([] { speed = 1.023f; });
+      bool fast = f->turbo;
+      if (ImGui::Checkbox("TURBO", &fast)) {                                    // the GUI keeps its vsync
+        core->post([fast] {
+          turbo = fast;
+          speaker->toggleMute();                                                // flush the queued sound
+        });
+      }
+      ImGui::SameLine();
+      bool fastDisk = f->fastDisk;
+      if (ImGui::Checkbox("FAST DISK", &fastDisk))                              // skips the polling of the RWTS
+        core->post([fastDisk] { disk->accelerated = fastDisk; });
+      ImGui::SameLine();
+      ImGui::Text("%.2f MHz", f->mhz);
+      bool pause = f->paused;
+      if (ImGui::Checkbox("PAUSE", &pause)) core->post([pause] { paused = pause; });
       ImGui::SameLine();
       if (ImGui::Button("STEP")) {
-        paused = true;
-        cpu->state = step;
+        core->post([] {
+          paused = true;
+          cpu->state = step;
+        });
       }
       ImGui::Separator();
-      if (ImGui::Button("RESET"))
-        cpu->RST();
+      int rewindMB = (int)(f->rewindBudget >> 20);
+      if (ImGui::SliderInt("REWIND", &rewindMB, 0, 256, "%d MB"))               // 0 disables the captures
+        core->post([rewindMB] { history->budget = (size_t)rewindMB << 20; });
+      ImGui::SameLine();
+      ImGui::Text("%.0f s, %.1f MB", f->rewindSeconds, f->rewindUsed / 1048576.0);
+      ImGui::Separator();
+      if (ImGui::Button("RESET")) {
+        core->post([] {
+          cpu->RST();
+          journal->input(J_RESET);
+        });
+      }
       ImGui::SameLine();
       if (ImGui::Button("POWER CYCLE")) {
-        cpu->RST();                                                             // do a cold reset
-        mmu->init();
-        mmu->ram[0x3F4] = 0;                                                    // unset the Power-UP byte
+        core->post([] {
+          cpu->RST();                                                           // do a cold reset
+          mmu->init();
+          mmu->ram[0x3F4] = 0;                                                  // unset the Power-UP byte
+          journal->input(J_POWER);
+        });
       }
+      ImGui::SameLine();
+      bool record = f->recording;
+      if (ImGui::Checkbox("RECORD", &record)) core->post(toggleRecording);
     ImGui::End();
   }
 
@@ -499,14 +698,14 @@ int Gui::update() {
   fileDialog1.Display();
   if (fileDialog1.HasSelected()) {
     floppy1 = fileDialog1.GetSelected().filename().string();
-    disk->load((char*)fileDialog1.GetSelected().string().c_str(), 0);
+    core->post([path = fileDialog1.GetSelected().string()] { disk->load((char*)path.c_str(), 0); });
     fileDialog1.ClearSelected();
   }
 
   fileDialog2.Display();
   if (fileDialog2.HasSelected()) {
     floppy2 = fileDialog2.GetSelected().filename().string();
-    disk->load((char*)fileDialog2.GetSelected().string().c_str(), 1);
+    core->post([path = fileDialog2.GetSelected().string()] { disk->load((char*)path.c_str(), 1); });
     fileDialog2.ClearSelected();
   }
 
@@ -515,23 +714,23 @@ int Gui::update() {
 
       if (ImGui::Button("LOAD FLOPPY #1")) {
         fileDialog1.SetTitle("Insert floppy into drive #1");
-        fileDialog1.SetTypeFilters({ ".nib", ".dsk", ".woz" });
+        fileDialog1.SetTypeFilters({ ".nib", ".dsk", ".do", ".po", ".woz" });
         fileDialog1.Open();
       }
       ImGui::SameLine();
       if (ImGui::Button("SAVE FLOPPY #1")) {
-        disk->save(0);
+        core->post([] { if (!disk->save(0)) core->message = "Could not save the floppy"; });
       }
       ImGui::SameLine();
       if (ImGui::Button("EJECT FLOPPY #1")) {
-        disk->eject(0);
+        core->post([] { disk->eject(0); });
       }
-      ImGui::Text("Floppy #1 : %s", disk->unit[0].fileName);
-      ImGui::Text("Read %s", disk->unit[0].readOnly ? "Only" : "and Write");
+      ImGui::Text("Floppy #1 : %s", f->fileName[0]);
+      ImGui::Text("Read %s", f->readOnly[0] ? "Only" : "and Write");
       ImGui::Text("Status : ");
       ImGui::SameLine();
-      if (disk->unit[0].motorOn) {
-        if (disk->unit[0].writeMode)
+      if (f->motorOn[0]) {
+        if (f->writeMode[0])
           ImGui::Text("writting");
         else
           ImGui::Text("reading");
@@ -543,23 +742,23 @@ int Gui::update() {
 
       if (ImGui::Button("LOAD FLOPPY #2")) {
         fileDialog2.SetTitle("Insert floppy into drive #2");
-        fileDialog2.SetTypeFilters({ ".nib", ".dsk", ".woz" });
+        fileDialog2.SetTypeFilters({ ".nib", ".dsk", ".do", ".po", ".woz" });
         fileDialog2.Open();
       }
       ImGui::SameLine();
       if (ImGui::Button("SAVE FLOPPY #2")) {
-        disk->save(1);
+        core->post([] { if (!disk->save(1)) core->message = "Could not save the floppy"; });
       }
       ImGui::SameLine();
       if (ImGui::Button("EJECT FLOPPY #2")) {
-        disk->eject(1);
+        core->post([] { disk->eject(1); });
       }
-      ImGui::Text("Floppy #2 : %s", disk->unit[1].fileName);
-      ImGui::Text("Read %s", disk->unit[1].readOnly ? "Only" : "and Write");
+      ImGui::Text("Floppy #2 : %s", f->fileName[1]);
+      ImGui::Text("Read %s", f->readOnly[1] ? "Only" : "and Write");
       ImGui::Text("Status : ");
       ImGui::SameLine();
-      if (disk->unit[1].motorOn) {
-        if (disk->unit[1].writeMode)
+      if (f->motorOn[1]) {
+        if (f->writeMode[1])
           ImGui::Text("writting");
         else
           ImGui::Text("reading");
@@ -567,67 +766,146 @@ int Gui::update() {
       else
         ImGui::Text("idle");
 
+      ImGui::Separator();
+
+      bool autosave = f->autosave;
+      if (ImGui::Checkbox("AUTOSAVE", &autosave))                               // the tracks written to, every few seconds
+        core->post([autosave] { disk->autosave = autosave; });
+
+    ImGui::End();
+  }
+
+  static std::vector<Title> titles;                                             // as the scanner left them
+  static unsigned int titlesVersion = 0;
+  static std::vector<int> found;                                                // the ones matching the search
+  static char search[64] = "";
+  static std::string searched;
+  if (library->latest(&titles, &titlesVersion) || searched != search) {         // even hidden, found must follow titles
+    searched = search;
+    std::string text = lowered(search);
+    found.clear();
+    for (int i = 0; i < (int)titles.size(); i++)
+      if (matches(titles[i], text)) found.push_back(i);
+  }
+
+  if (show_library_window) {
+    ImGui::Begin("LIBRARY", &show_library_window);
+      if (ImGui::Button("FOLDER")) {
+        folderDialog.SetTitle("Index the floppies under this folder");
+        folderDialog.Open();
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("RESCAN") && !library->folder().empty())
+        library->scan(library->folder());
+      ImGui::SameLine();
+      ImGui::Text("%d floppies%s", (int)titles.size(), library->scanning ? ", scanning" : "");
+      ImGui::InputTextWithHint("##search", "title, volume or file name", search, IM_ARRAYSIZE(search));
+      ImGui::Separator();
+      ImGui::BeginChild("titles");
+        for (int i : found) {
+          const Title& title = titles[i];
+          std::string name = std::filesystem::path(title.path).filename().string();
+          bool open = ImGui::TreeNode(title.path.c_str(), "%s  %s %s", name.c_str(),
+                                      title.system.c_str(), title.volume.c_str());
+          if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0))          // boots it in drive #1
+            core->post([path = title.path] { insertFloppy(path, 0, true); });
+          if (open) {                                                           // its catalog
+            for (const std::string& file : title.files) ImGui::TextUnformatted(file.c_str());
+            ImGui::TreePop();
+          }
+        }
+      ImGui::EndChild();
     ImGui::End();
   }
 
+  folderDialog.Display();
+  if (folderDialog.HasSelected()) {
+    library->scan(folderDialog.GetSelected().string());
+    folderDialog.ClearSelected();
+  }
+
   if (show_info_window) {
     ImGui::Begin("INFO", &show_info_window);
       // Display FPS
       ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+      ImGui::Text("emulated : %.2f MHz", f->mhz);
       ImGui::Separator();
-      ImGui::Text("KEY   : %02X", mmu->KBD);
+      ImGui::Text("KEY   : %02X", f->KBD);
       ImGui::Separator();
-      ImGui::Checkbox("TEXT", &mmu->TEXT);
-      ImGui::Checkbox("MIXED", &mmu->MIXED);
-      ImGui::Checkbox("PAGE2", &mmu->PAGE2);
-      ImGui::Checkbox("HIRES", &mmu->HIRES);
-      ImGui::Checkbox("DHIRES", &mmu->DHIRES);
-      ImGui::Checkbox("COL80", &mmu->COL80);
+      bool sw = f->TEXT;                                                        // soft switches set by the core
+      if (ImGui::Checkbox("TEXT", &sw)) core->post([sw] { mmu->TEXT = sw; video->setMode(); });
+      sw = f->MIXED;
+      if (ImGui::Checkbox("MIXED", &sw)) core->post([sw] { mmu->MIXED = sw; video->setMode(); });
+      sw = f->PAGE2;                                                            // PAGE2 and HIRES
+      if (ImGui::Checkbox("PAGE2", &sw)) core->post([sw] { mmu->PAGE2 = sw; mmu->mapPages(); video->setMode(); });
+      sw = f->HIRES;                                                            // can remap memory with 80STORE
+      if (ImGui::Checkbox("HIRES", &sw)) core->post([sw] { mmu->HIRES = sw; mmu->mapPages(); video->setMode(); });
+      sw = f->DHIRES;
+      if (ImGui::Checkbox("DHIRES", &sw)) core->post([sw] { mmu->DHIRES = sw; video->setMode(); });
+      sw = f->COL80;
+      if (ImGui::Checkbox("COL80", &sw)) core->post([sw] { mmu->COL80 = sw; video->setMode(); });
       ImGui::Separator();
-      ImGui::Text("Language Card readable : %s", mmu->LCRD  ? "True" : "False");
-      ImGui::Text("Language Card writable : %s", mmu->LCWR  ? "True" : "False");
-      ImGui::Text("Language Card bank 2   : %s", mmu->LCBK2 ? "Enabled" : "Disabled");
-      ImGui::Text("Language Card prewrite : %s", mmu->LCWFF ? "On" : "Off");
+      ImGui::Text("Language Card readable : %s", f->LCRD    ? "True" : "False");
+      ImGui::Text("Language Card writable : %s", f->LCWR    ? "True" : "False");
+      ImGui::Text("Language Card bank 2   : %s", f->LCBK2   ? "Enabled" : "Disabled");
+      ImGui::Text("Language Card prewrite : %s", f->LCWFF   ? "On" : "Off");
       ImGui::Separator();
-      ImGui::Text("RAMRD      : %s", mmu->RAMRD      ? "On" : "Off");
-      ImGui::Text("RAMWRT     : %s", mmu->RAMWRT     ? "On" : "Off");
-      ImGui::Text("ALTZP      : %s", mmu->ALTZP      ? "On" : "Off");
-      ImGui::Text("STORE80    : %s", mmu->STORE80    ? "On" : "Off");
-      ImGui::Text("ALTCHARSET : %s", mmu->ALTCHARSET ? "On" : "Off");
-      ImGui::Text("INTCXROM   : %s", mmu->INTCXROM   ? "On" : "Off");
-      ImGui::Text("SLOTC3ROM  : %s", mmu->SLOTC3ROM  ? "On" : "Off");
+      ImGui::Text("RAMRD      : %s", f->RAMRD        ? "On" : "Off");
+      ImGui::Text("RAMWRT     : %s", f->RAMWRT       ? "On" : "Off");
+      ImGui::Text("ALTZP      : %s", f->ALTZP        ? "On" : "Off");
+      ImGui::Text("STORE80    : %s", f->STORE80      ? "On" : "Off");
+      ImGui::Text("ALTCHARSET : %s", f->ALTCHARSET   ? "On" : "Off");
+      ImGui::Text("INTCXROM   : %s", f->INTCXROM     ? "On" : "Off");
+      ImGui::Text("SLOTC3ROM  : %s", f->SLOTC3ROM    ? "On" : "Off");
       ImGui::Separator();
-      ImGui::Text("VERTBLANK  : %s", mmu->VERTBLANK  ? "On" : "Off");
+      ImGui::Text("VERTBLANK  : %s", f->inVBL      ? "On" : "Off");
+      ImGui::Text("BEAM LINE  : %d", f->beamLine);
     ImGui::End();
   }
 
   if (show_cpu_window) {
-    char buffer[1000];
-    cpu->getRegs(buffer);
     ImGui::Begin("REGISTERS", &show_cpu_window);
-      ImGui::Text("%s", buffer);
+      ImGui::Text("%s", f->regs);
       // ImGui::Text("TICK : %lld", ticks);
     ImGui::End();
   }
 
-  static char buffer[2000];
   static char addressString[5];
   static unsigned long int address = 0xFF00;
   static bool followPC = true;
 
+  core->codeShown = show_code_window;                                           // disassembled by the core
   if (show_code_window) {
     ImGui::Begin("CODE", &show_code_window);
-      if( ImGui::InputTextWithHint("", "address in hex", addressString, IM_ARRAYSIZE(addressString))) {
+      if( ImGui::InputTextWithHint("", "address in hex", addressString, IM_ARRAYSIZE(addressString)))
         address = strtoul(addressString, NULL, 16);
-        cpu->getCode(address, buffer, 2000, 20);
-      }
       ImGui::SameLine();
       ImGui::Checkbox("PC", &followPC);
-      if (followPC)
-        cpu->getCode(cpu->getPC(), buffer, 2000, 20);
-      ImGui::Text("%s", buffer);
+      core->codeAddress = followPC ? -1 : (int)(address & 0xFFFF);
+      ImGui::Text("%s", f->code);
+    ImGui::End();
+  }
+
+#ifdef TRACE
+  core->traceShown = show_trace_window;                                         // disassembled by the core
+  if (show_trace_window) {
+    ImGui::Begin("TRACE", &show_trace_window);
+      if (ImGui::Button("DUMP"))
+        core->post([] { if (!trace->dump(TRACE_FILE)) core->message = "Could not write " TRACE_FILE; });
+      ImGui::SameLine();
+      if (ImGui::Button("CLEAR"))
+        core->post([] { trace->clear(); });
+      ImGui::SameLine();
+      static bool followLast = true;
+      ImGui::Checkbox("FOLLOW", &followLast);
+      ImGui::Separator();
+      ImGui::BeginChild("instructions", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+        ImGui::TextUnformatted(f->trace);
+        if (followLast) ImGui::SetScrollHereY(1.0f);                            // the last instruction run
+      ImGui::EndChild();
     ImGui::End();
   }
+#endif
 
   if (show_editor_window) {
     ImGui::Begin("EDITOR", &show_editor_window, ImGuiWindowFlags_HorizontalScrollbar);
@@ -638,12 +916,7 @@ int Gui::update() {
           std::string program = "NEW\n";
           program += editor.GetSelectedText();
           program += "\nRUN\n";
-          int c = 0;
-          while (program[c]) {                                                  // all chars until ascii NUL
-            mmu->KBD = program[c++] | 0x80;                                          // set bit7
-            if (mmu->KBD == 0x8A) mmu->KBD = 0x8D;                                        // translate Line Feed to Carriage Ret
-            cpu->exec(500000);                                                   // give cpu (and applesoft) some cycles to process each char
-          }
+          core->post([program] { typeText(program, 500000); });
         }
       }
       ImGui::SameLine();
@@ -652,17 +925,16 @@ int Gui::update() {
           std::string program = "\n";
           program += editor.GetSelectedText();
           program += "\n";
-          int c = 0;
-          while (program[c]) {                                                  // all chars until ascii NUL
-            mmu->KBD = program[c++] | 0x80;                                          // set bit7
-            if (mmu->KBD == 0x8A) mmu->KBD = 0x8D;                                        // translate Line Feed to Carriage Ret
-            cpu->exec(500000);                                                   // give cpu (and applesoft) some cycles to process each char
-          }
+          core->post([program] { typeText(program, 500000); });
         }
       }
       ImGui::SameLine();
-      if (ImGui::Button("SEND RESET"))
-        cpu->RST();
+      if (ImGui::Button("SEND RESET")) {
+        core->post([] {
+          cpu->RST();
+          journal->input(J_RESET);
+        });
+      }
       ImGui::Separator();
 
       auto cpos = editor.GetCursorPosition();
@@ -686,7 +958,8 @@ int Gui::update() {
       auto image_size = ImVec2(280 * screenScale, 192 * screenScale);
       ImGui::SetWindowSize(ImVec2(280 * screenScale + 16, 192 * screenScale + 50));
       // Draw image
-      ImGui::Image((void*)((intptr_t)screenTexture), image_size, ImVec2(0,0), ImVec2(1,1), ImColor(255,255,255,255), ImColor(0,0,0,0));
+      uint32_t texture = uploadedMode == 80 ? screenTexture80 : screenTexture;
+      ImGui::Image((void*)((intptr_t)texture), image_size, ImVec2(0,0), ImVec2(1,1), ImColor(255,255,255,255), ImColor(0,0,0,0));
       // get inputs
       CRT_is_focused = ImGui::IsWindowFocused(ImGuiFocusedFlags_ChildWindows);
     ImGui::End();
@@ -696,31 +969,59 @@ int Gui::update() {
 }
 
 
-int Gui::render() {
-  // crt
-  if (video->gfxmode == 80) {
-    glBindTexture(GL_TEXTURE_2D, screenTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 560, 384, 0, GL_RGBA, GL_UNSIGNED_BYTE, video->screenPixels80);
-  }
-  else {
-    glBindTexture(GL_TEXTURE_2D, screenTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 280, 192, 0, GL_RGBA, GL_UNSIGNED_BYTE, video->screenPixels);
+void Gui::uploadRows(uint32_t texture, int width, int first, int last, const uint32_t* pixels) {
+  glBindTexture(GL_TEXTURE_2D, texture);
+#ifdef PBO
+  GLsizeiptr size = (GLsizeiptr)width * (last - first) * sizeof(uint32_t);
+  pixelBuffer = !pixelBuffer;                                                   // the other buffer may still be in use
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[pixelBuffer]);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);             // discard its previous content
+  void* mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+  if (mapped) {
+    memcpy(mapped, pixels + width * first, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, width, last - first, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return;
   }
-  // RAM heatmap
-  glBindTexture(GL_TEXTURE_2D, ramHeatmapTexture);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, video->ramHeatmap);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);                                      // could not map, upload directly
+#endif
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, width, last - first, GL_RGBA, GL_UNSIGNED_BYTE, pixels + width * first);
+}
 
-  // AUX heatmap
-  glBindTexture(GL_TEXTURE_2D, auxHeatmapTexture);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, video->auxHeatmap);
+
+int Gui::render() {
+  if (freshFrame) {                                                             // a new frame from the core
+    // crt, only the lines drawn since the last upload
+    int buffer = frame->gfxmode == 80;
+    int first = frame->drawnFirst[buffer], last = frame->drawnLast[buffer];
+    if (frame->gfxmode != uploadedMode) {                                       // the other texture missed the lines
+      first = 0;                                                                // drawn while it was not shown
+      last = 192;
+      uploadedMode = frame->gfxmode;
+    }
+    if (first < last) {
+      if (buffer)
+        uploadRows(screenTexture80, 560, first * 2, last * 2, frame->screenPixels80);
+      else
+        uploadRows(screenTexture, 280, first, last, frame->screenPixels);
+    }
+
+#ifdef HEATMAP
+    // RAM heatmap, converted to pixels by the core only when visible
+    if (show_ramHeatmap_window) {
+      glBindTexture(GL_TEXTURE_2D, ramHeatmapTexture);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 256, GL_RGBA, GL_UNSIGNED_BYTE, frame->heatmap[MAIN_BANK]);
+    }
+
+    // AUX heatmap
+    if (show_auxHeatmap_window) {
+      glBindTexture(GL_TEXTURE_2D, auxHeatmapTexture);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 256, GL_RGBA, GL_UNSIGNED_BYTE, frame->heatmap[AUX_BANK]);
+    }
+#endif
+    freshFrame = false;
+  }
 
   // Rendering
   ImGui::Render();
@@ -731,8 +1032,6 @@ int Gui::render() {
   glClear(GL_COLOR_BUFFER_BIT);
   ImGui_ImplOpenGL2_RenderDrawData(ImGui::GetDrawData());
   SDL_GL_SwapWindow(wdo);
-
-  if (++frameNumber >= 60) frameNumber = 0;                                     // reset to zero every second
   return 1;
 }
 
@@ -37,14 +37,17 @@
 #include "TextEditor.h"
 
 #include <SDL2/SDL.h>
+#ifdef PBO
+#define GL_GLEXT_PROTOTYPES     // pixel buffer objects entry points
+#endif
 #include <SDL_opengl.h>
 #include <fstream>
 
-class Gui {
-public:
-  int fps;
-  unsigned int  frameNumber;
+#define STATE_FILE "reinette.state"   // F2 saves the machine there, shift F2 restores it
+#define JOURNAL_FILE "reinette.journal" // F8 records the inputs there, replay with reinette-headless -j
+#define TRACE_FILE "reinette.trace"     // the TRACE window dumps the instruction trace there
 
+class Gui {
 private:
   bool show_about_window;
   bool show_help_window;
@@ -63,11 +66,23 @@ private:
   bool show_editor_window;
   bool show_ramHeatmap_window;
   bool show_auxHeatmap_window;
+  bool show_trace_window;
+  bool show_library_window;
 
   ImVec4 clear_color;
-  uint32_t screenTexture;
+  uint32_t screenTexture;         // 280x192
+  uint32_t screenTexture80;       // 560x384
   uint32_t ramHeatmapTexture;
   uint32_t auxHeatmapTexture;
+#ifdef PBO
+  uint32_t pixelBuffers[2];       // filled in turn, while the other one is uploaded
+  int pixelBuffer;
+#endif
+
+  Frame* frame;                   // last frame completed by the core
+  bool freshFrame;                // not uploaded yet
+  int uploadedMode;               // gfxmode of the texture shown
+  uint8_t buttons[3];             // push buttons sent to the core
 
   SDL_Window* wdo;
   float screenScale;
@@ -77,6 +92,7 @@ private:
   std::string fileToEdit;
   ImGui::FileBrowser fileDialog1;
   ImGui::FileBrowser fileDialog2;
+  ImGui::FileBrowser folderDialog { ImGuiFileBrowserFlags_SelectDirectory };    // for the LIBRARY
 
 public:
   Gui();
@@ -86,6 +102,9 @@ public:
   int newFrame();
   int render();
   int release();
+
+private:
+  void uploadRows(uint32_t texture, int width, int first, int last, const uint32_t* pixels);
 };
 
 #endif
@@ -0,0 +1,266 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// headless front end : no SDL window, audio or OpenGL
+// runs a disk image, resumes a saved state or replays an inputs journal, for a
+// number of cycles, optionally typing keystrokes from a script, then dumps the
+// screen (.ppm) and the MAIN and AUX RAM (.ram), and optionally saves the state
+// and the instruction trace. Or indexes a folder of floppies (-i), as the
+// LIBRARY window does, and lists them
+//
+// keystroke script : one entry per line, '#' starts a comment
+//   <cycle> <text>    types <text> followed by RETURN once cpu->ticks reaches <cycle>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "reinette.h"
+
+bool  running = true;
+bool  paused  = false;
+float speed   = 1.023f;
+bool  turbo   = true;                                                           // never throttled
+float mhz     = 0.0f;
+
+Mmu*       mmu     = new Mmu();
+puce65c02* cpu     = new puce65c02();
+Video*     video   = new Video();
+Disk*      disk    = new Disk();
+Paddles*   paddles = new Paddles();
+Heatmap*   heatmap = new Heatmap();
+#ifdef TRACE
+Trace*     trace   = new Trace();
+#endif
+Journal*   journal = new Journal();
+Library*   library = new Library();
+
+
+typedef struct Keystroke_t {
+  unsigned long long int cycle;                                                 // when to type it
+  uint8_t key;                                                                  // Apple II key code, bit 7 set
+} Keystroke;
+
+
+static int loadScript(const char* path, Keystroke** keys) {
+  FILE* f = fopen(path, "r");
+  if (!f) return -1;
+
+  int count = 0, size = 256;
+  *keys = (Keystroke*)malloc(size * sizeof(Keystroke));
+  char line[1024];
+
+  while (fgets(line, sizeof(line), f)) {
+    char* text;
+    unsigned long long int cycle = strtoull(line, &text, 10);
+    if (line[0] == '#' || text == line) continue;                               // comment or no cycle
+    if (*text == ' ' || *text == '\t') text++;                                  // single separator, the rest is typed
+    for (int i = 0; ; i++) {
+      if (count == size) *keys = (Keystroke*)realloc(*keys, (size *= 2) * sizeof(Keystroke));
+      char c = text[i];
+      bool eol = (c == 0 || c == '\n' || c == '\r');
+      (*keys)[count].cycle = cycle;
+      (*keys)[count++].key = eol ? 0x8D : (c | 0x80);                           // end of line becomes RETURN
+      if (eol) break;
+    }
+  }
+  fclose(f);
+  return count;
+}
+
+
+static int dumpScreen(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return 0;
+
+  int width  = video->gfxmode == 80 ? 560 : 280;
+  int height = video->gfxmode == 80 ? 384 : 192;
+  uint32_t* pixels = video->gfxmode == 80 ? video->screenPixels80 : video->screenPixels;
+
+  fprintf(f, "P6\n%d %d\n255\n", width, height);
+  for (int i = 0; i < width * height; i++) {                                    // pixels are 0xAABBGGRR
+    uint8_t rgb[3] = { (uint8_t)pixels[i], (uint8_t)(pixels[i] >> 8), (uint8_t)(pixels[i] >> 16) };
+    fwrite(rgb, 1, 3, f);
+  }
+  fclose(f);
+  return 1;
+}
+
+
+static int dumpRam(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return 0;
+  int ok = fwrite(mmu->ram, 1, RAMSIZE, f) == RAMSIZE && fwrite(mmu->aux, 1, AUXSIZE, f) == AUXSIZE;
+  fclose(f);
+  return ok;
+}
+
+
+static void runCycles(unsigned long long int cycles) {                          // cpu->exec, stopping at each journal input
+  unsigned long long int target = cpu->ticks + cycles;
+  while (cpu->ticks < target) {
+    journal->replay();                                                          // the inputs due by now
+    unsigned long long int until = journal->nextTick();
+    cpu->exec((until < target ? until : target) - cpu->ticks);
+  }
+}
+
+
+static void usage(const char* name) {
+  fprintf(stderr, "usage: %s [-c cycles] [-k script] [-o prefix] [-l state] [-s state] [-j journal] [-t trace] [-e] [-w] [-i folder] [image]\n"
+                  "  -c cycles  run until cpu->ticks reaches cycles (default 30000000)\n"
+                  "  -k script  keystroke script, lines of '<cycle> <text>'\n"
+                  "  -o prefix  dump the screen to prefix.ppm and RAM to prefix.ram (default 'reinette')\n"
+                  "  -l state   resume from a saved state instead of booting\n"
+                  "  -s state   save the state of the machine when done\n"
+                  "  -j journal replay the inputs recorded from the GUI (F8), from the state they started at\n"
+                  "  -t trace   dump the last instructions run when done (built with TRACE=1)\n"
+                  "  -e         exact disk timing, no accelerated disk access\n"
+                  "  -w         save the tracks written to back to the image when done\n"
+                  "  -i folder  index the floppies under folder into " LIBRARY_FILE ", list them and quit\n"
+                  "  image      floppy in drive 0 : .nib, .dsk/.do (DOS order), .po (ProDOS order) or .woz\n", name);
+}
+
+
+int main(int argc, char *argv[]) {
+  unsigned long long int budget = 30000000ULL;
+  const char* script = NULL;
+  const char* prefix = "reinette";
+  const char* image = NULL;
+  const char* loadPath = NULL;
+  const char* savePath = NULL;
+  const char* journalPath = NULL;
+  const char* tracePath = NULL;
+  bool writeBack = false;
+  const char* folder = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-c") && i + 1 < argc) budget = strtoull(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "-k") && i + 1 < argc) script = argv[++i];
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc) prefix = argv[++i];
+    else if (!strcmp(argv[i], "-l") && i + 1 < argc) loadPath = argv[++i];
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc) savePath = argv[++i];
+    else if (!strcmp(argv[i], "-j") && i + 1 < argc) journalPath = argv[++i];
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc) tracePath = argv[++i];
+    else if (!strcmp(argv[i], "-e")) disk->accelerated = false;
+    else if (!strcmp(argv[i], "-w")) writeBack = true;
+    else if (!strcmp(argv[i], "-i") && i + 1 < argc) folder = argv[++i];
+    else if (argv[i][0] != '-' && !image) image = argv[i];
+    else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (folder) {                                                                 // images changed since the last index only
+    library->load(LIBRARY_FILE);
+    library->scan(folder);
+    library->wait();
+    std::vector<Title> titles;
+    unsigned int version = 0;
+    library->latest(&titles, &version);
+    for (const Title& title : titles) {
+      printf("%s\t%s\t%s\n", title.path.c_str(), title.system.c_str(), title.volume.c_str());
+      for (const std::string& file : title.files)
+        printf("\t%s\n", file.c_str());
+    }
+    return EXIT_SUCCESS;
+  }
+
+  Keystroke* keys = NULL;
+  int numKeys = 0, nextKey = 0;
+  if (script && (numKeys = loadScript(script, &keys)) < 0) {
+    fprintf(stderr, "Could not read keystroke script %s\n", script);
+    return EXIT_FAILURE;
+  }
+
+  cpu->RST();
+  if (image && !disk->load((char*)image, 0)) {                                  // load floppy into drive 0
+    fprintf(stderr, "Not a valid floppy image : %s\n", image);
+    return EXIT_FAILURE;
+  }
+
+  State* state = new State();
+  if (loadPath && !(state->read(loadPath) && state->restore())) {               // replaces the booted machine
+    fprintf(stderr, "Not a valid state file : %s\n", loadPath);
+    return EXIT_FAILURE;
+  }
+  if (journalPath && !journal->load(journalPath)) {                             // so does a journal
+    fprintf(stderr, "Not a valid journal file : %s\n", journalPath);
+    return EXIT_FAILURE;
+  }
+
+  const int fps = 60;
+
+  auto start = std::chrono::steady_clock::now();
+
+  // same frame pacing as the GUI, without the video
+  while (running && cpu->ticks < budget) {
+
+    if (nextKey < numKeys && cpu->ticks >= keys[nextKey].cycle && !(mmu->KBD & 0x80))
+      mmu->KBD = keys[nextKey++].key;                                           // previous key was read, type the next one
+
+    runCycles((unsigned long long int)(1000000.0 * speed / fps));
+
+    unsigned long long int burst = cpu->ticks + DISK_BURST;                     // speed up drive access
+    while (disk->accelerated && disk->unit[disk->curDrv].motorOn && cpu->ticks < burst)
+      runCycles(5000);
+
+    if (!journal->replaying) paddles->update();                                 // the journal has the paddle positions
+    if (++video->frameNumber >= 60) video->frameNumber = 0;
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  mhz = (float)(cpu->ticks / elapsed.count() / 1000000.0);
+
+  video->clearCache();                                                          // render the last frame only
+  video->update();
+
+  char path[1024];
+  snprintf(path, sizeof(path), "%s.ppm", prefix);
+  if (!dumpScreen(path)) fprintf(stderr, "Could not write %s\n", path);
+  snprintf(path, sizeof(path), "%s.ram", prefix);
+  if (!dumpRam(path)) fprintf(stderr, "Could not write %s\n", path);
+
+  if (savePath) {
+    state->snapshot();
+    if (!state->write(savePath)) fprintf(stderr, "Could not write %s\n", savePath);
+  }
+
+  if (writeBack && !disk->save(0)) fprintf(stderr, "Could not save %s\n", disk->unit[0].pathName);
+
+  if (tracePath) {
+#ifdef TRACE
+    if (!trace->dump(tracePath)) fprintf(stderr, "Could not write %s\n", tracePath);
+#else
+    fprintf(stderr, "No trace recorded, build with TRACE=1\n");
+#endif
+  }
+
+  printf("ticks=%llu PC=%04X keys=%d/%d MHz=%.2f\n", cpu->ticks, cpu->getPC(), nextKey, numKeys, mhz);
+  free(keys);
+  delete state;
+  return 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "reinette.h"
+
+Heatmap::Heatmap() {
+  memset(reads,  0, sizeof(reads));
+  memset(writes, 0, sizeof(writes));
+  memset(pixels, 0, sizeof(pixels));
+  frames = 0x100;                                                               // every address faded out already
+}
+
+
+static inline uint32_t intensity(uint32_t frames, uint32_t last) {              // 0xFF minus the frames since the access,
+  uint32_t elapsed = frames - last;                                             // down to 0
+  return elapsed > 0xFF ? 0 : 0xFF - elapsed;
+}
+
+
+uint32_t* Heatmap::expand(int bank) {
+  for (int address = 0; address < 0x10000; address++)                          // ABGR : reads in green, writes in red
+    pixels[bank][address] = 0xFF000000 | (intensity(frames, reads[bank][address]) << 8)
+                                       | intensity(frames, writes[bank][address]);
+  return pixels[bank];
+}
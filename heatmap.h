@@ -0,0 +1,55 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __HEATMAP_H__
+#define __HEATMAP_H__
+
+// memory access heatmaps, build with -DHEATMAP (make HEATMAP=1) to record them
+// each address keeps the frame it was last read and last written in. Its read
+// and write intensities, 0xFF when accessed and one less every frame after, are
+// worked out from these frame numbers when a bank is turned into RGBA pixels for
+// display : nothing is done while hidden, and a bank shown again after a while
+// looks as if it had been faded every frame.
+
+#define MAIN_BANK 0
+#define AUX_BANK  1
+
+class Heatmap {
+public:
+  uint32_t reads[2][0x10000];                                                   // MAIN and AUX last read frames (green)
+  uint32_t writes[2][0x10000];                                                  // MAIN and AUX last write frames (red)
+  uint32_t pixels[2][0x10000];                                                  // RGBA, only valid after expand()
+  uint32_t frames;                                                              // frames elapsed, wraps around
+
+  Heatmap();
+
+  inline void read(int bank, uint16_t address) { reads[bank][address] = frames; }
+  inline void write(int bank, uint16_t address) { writes[bank][address] = frames; }
+  inline void frame() { frames++; }                                             // once per video frame
+
+  uint32_t* expand(int bank);                                                   // build the RGBA image of a bank
+};
+
+#endif
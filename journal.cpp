@@ -0,0 +1,156 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include "reinette.h"
+
+Journal::Journal() {
+  recording = false;
+  replaying = false;
+  next = 0;
+  state = new State();
+}
+
+
+Journal::~Journal() {
+  delete state;
+}
+
+
+//====================================================================== RECORD
+
+void Journal::start() {
+  state->snapshot();
+  events.clear();
+  buttons[0] = paddles->PB0;
+  buttons[1] = paddles->PB1;
+  buttons[2] = paddles->PB2;
+  for (int pdl = 0; pdl < 4; pdl++) positions[pdl] = paddles->GCP[pdl];
+  replaying = false;
+  recording = true;
+}
+
+
+void Journal::input(uint8_t type, uint8_t index, float value) {
+  if (recording) events.push_back({ cpu->ticks, type, index, value });
+}
+
+
+void Journal::poll() {                                                          // once per frame, after paddles->update()
+  if (!recording) return;
+  uint8_t pb[3] = { paddles->PB0, paddles->PB1, paddles->PB2 };
+  for (int b = 0; b < 3; b++)
+    if (pb[b] != buttons[b]) input(J_BUTTON, b, buttons[b] = pb[b]);
+  for (int pdl = 0; pdl < 4; pdl++)
+    if (paddles->GCP[pdl] != positions[pdl]) input(J_PADDLE, pdl, positions[pdl] = paddles->GCP[pdl]);
+}
+
+
+int Journal::stop(const char* path) {
+  recording = false;
+  FILE* f = fopen(path, "wb");
+  if (!f) return 0;
+
+  uint32_t header[4] = { JOURNAL_MAGIC, JOURNAL_VERSION, (uint32_t)state->size, (uint32_t)events.size() };
+  bool ok = fwrite(header, sizeof(header), 1, f) == 1
+         && fwrite(state->data, 1, state->size, f) == state->size;
+  for (const Event& e : events)
+    ok = ok && fwrite(&e.ticks, sizeof(e.ticks), 1, f) && fwrite(&e.type, 1, 1, f)
+            && fwrite(&e.index, 1, 1, f) && fwrite(&e.value, sizeof(e.value), 1, f);
+  fclose(f);
+  return ok;
+}
+
+
+//====================================================================== REPLAY
+
+int Journal::load(const char* path) {
+  events.clear();                                                               // nothing left to replay if this fails
+  replaying = false;
+  FILE* f = fopen(path, "rb");
+  if (!f) return 0;
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  const size_t eventSize = sizeof(Event::ticks) + 2 + sizeof(Event::value);     // as written by save()
+  uint32_t header[4];
+  bool ok = size > 0 && fread(header, sizeof(header), 1, f) == 1
+         && header[0] == JOURNAL_MAGIC && header[1] == JOURNAL_VERSION
+         && header[2] <= size - sizeof(header)                                  // sizes within the file, before allocating
+         && header[3] <= (size - sizeof(header) - header[2]) / eventSize;
+  if (ok) {
+    state->size = 0;
+    std::vector<uint8_t> data(header[2]);
+    ok = fread(data.data(), 1, data.size(), f) == data.size();
+    state->put(data.data(), data.size());
+  }
+  for (uint32_t i = 0; ok && i < header[3]; i++) {
+    Event e;
+    ok = fread(&e.ticks, sizeof(e.ticks), 1, f) && fread(&e.type, 1, 1, f)
+      && fread(&e.index, 1, 1, f) && fread(&e.value, sizeof(e.value), 1, f);
+    events.push_back(e);
+  }
+  fclose(f);
+
+  if (!ok || !state->restore()) {
+    events.clear();
+    return 0;
+  }
+  next = 0;
+  recording = false;
+  replaying = true;
+  return 1;
+}
+
+
+unsigned long long int Journal::nextTick() {
+  return replaying && next < events.size() ? events[next].ticks : ~0ULL;
+}
+
+
+void Journal::replay() {
+  while (replaying && next < events.size() && events[next].ticks <= cpu->ticks)
+    apply(events[next++]);
+}
+
+
+void Journal::apply(const Event& e) {
+  switch (e.type) {
+    case J_KEY:    mmu->KBD = (uint8_t)e.value; break;
+    case J_BUTTON:
+      if (e.index == 0) paddles->PB0 = (uint8_t)e.value;
+      if (e.index == 1) paddles->PB1 = (uint8_t)e.value;
+      if (e.index == 2) paddles->PB2 = (uint8_t)e.value;
+    break;
+    case J_PADDLE: paddles->GCP[e.index & 3] = e.value; break;
+    case J_RESET:  cpu->RST(); break;
+    case J_POWER:                                                               // same as the POWER CYCLE button
+      cpu->RST();
+      mmu->init();
+      mmu->ram[0x3F4] = 0;
+    break;
+  }
+}
@@ -0,0 +1,76 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include <vector>
+
+// input journal : the state of the machine when the recording started, then
+// every key, push button, paddle position and reset made by the user, stamped
+// with cpu->ticks. Replaying applies each input at the very tick it was made,
+// so the run is the same, instruction for instruction, whatever the pacing.
+// Disk changes and debugger edits are not recorded.
+
+#define JOURNAL_MAGIC   0x4A544E52                                              // "RNTJ"
+#define JOURNAL_VERSION 1
+
+enum { J_KEY, J_BUTTON, J_PADDLE, J_RESET, J_POWER };
+
+class Journal {
+public:
+  bool recording;
+  bool replaying;
+
+  Journal();
+  ~Journal();
+
+  void start();                                                                 // snapshot the machine and record
+  int  stop(const char* path);                                                  // write what was recorded
+  void input(uint8_t type, uint8_t index = 0, float value = 0.0f);              // an input was just made
+  void poll();                                                                  // record the buttons and paddles that moved
+
+  int  load(const char* path);                                                  // restore the machine and replay
+  void replay();                                                                // apply the inputs due by now
+  unsigned long long int nextTick();                                            // when the next one is due
+
+private:
+  typedef struct Event_t {
+    unsigned long long int ticks;
+    uint8_t type;
+    uint8_t index;                                                              // button or paddle number
+    float value;                                                                // key code, button or paddle position
+  } Event;
+
+  std::vector<Event> events;
+  size_t next;                                                                  // next event to replay
+  uint8_t buttons[3];                                                           // last recorded values
+  float positions[4];
+  State* state;                                                                 // the machine at the start
+
+  void apply(const Event& event);
+};
+
+#endif
@@ -0,0 +1,392 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include "reinette.h"
+
+Library::Library() {
+  scanning = false;
+  changes = 0;
+  quit = false;
+}
+
+
+Library::~Library() {
+  stop();
+}
+
+
+//================================================================== CATALOGS
+
+typedef struct Volume_t {                                                       // sectors decoded when first read
+  const uint8_t* nibbles;
+  int format;                                                                   // sector order, IMG_DOS or IMG_PRODOS
+  uint8_t image[DSK_SIZE];
+  uint64_t decoded;                                                             // one bit per track
+} Volume;
+
+
+static const uint8_t* sector(Volume* v, int track, int sector) {
+  if (!(v->decoded >> track & 1)) {
+    Disk::denibblize(v->nibbles, v->image, v->format, track);                   // the sectors found, the others stay 0
+    v->decoded |= 1ULL << track;
+  }
+  return v->image + (track * 16 + sector) * 256;
+}
+
+
+static const uint8_t* block(Volume* v, int block) {                             // ProDOS order, two sectors
+  return sector(v, block / 8, block % 8 * 2);
+}
+
+
+static std::string name(const uint8_t* chars, int length) {                     // printable, without the trailing spaces
+  std::string text;
+  for (int i = 0; i < length; i++) {
+    char c = chars[i] & 0x7F;
+    text += c >= 0x20 && c < 0x7F ? c : '.';
+  }
+  text.erase(text.find_last_not_of(' ') + 1);
+  return text;
+}
+
+
+static bool dosCatalog(Volume* v, Title* title) {                               // VTOC on track 17, then the catalog sectors
+  v->format = IMG_DOS;
+  v->decoded = 0;
+  const uint8_t* vtoc = sector(v, 17, 0);
+  if (vtoc[0x27] != 122 || vtoc[0x35] != 16 || vtoc[1] >= 35 || vtoc[2] >= 16)
+    return false;
+
+  title->system = "DOS 3.3";
+  title->volume = "DISK VOLUME " + std::to_string(vtoc[6]);
+  int track = vtoc[1], sec = vtoc[2];
+  for (int count = 0; count < 64 && track && track < 35 && sec < 16; count++) { // chained, and maybe looping
+    const uint8_t* s = sector(v, track, sec);
+    for (int i = 0; i < 7; i++) {
+      const uint8_t* entry = s + 0x0B + i * 35;
+      if (entry[0] == 0x00) return true;                                        // never used, the end
+      if (entry[0] == 0xFF) continue;                                           // deleted
+      char type = 'T';
+      for (int bit = 0; bit < 7; bit++)
+        if (entry[2] & (1 << bit)) { type = "IABSRAB"[bit]; break; }
+      char line[48];
+      snprintf(line, sizeof(line), "%c%c %03d %s", entry[2] & 0x80 ? '*' : ' ', type,
+               (entry[0x21] | entry[0x22] << 8) % 1000, name(entry + 3, 30).c_str());
+      title->files.push_back(line);
+    }
+    track = s[1];
+    sec = s[2];
+  }
+  return true;
+}
+
+
+static const char* prodosType(uint8_t type, char* hex) {
+  switch (type) {
+    case 0x04: return "TXT";
+    case 0x06: return "BIN";
+    case 0x0F: return "DIR";
+    case 0xB3: return "S16";
+    case 0xFA: return "INT";
+    case 0xFC: return "BAS";
+    case 0xFD: return "VAR";
+    case 0xFE: return "REL";
+    case 0xFF: return "SYS";
+  }
+  snprintf(hex, 4, "$%02X", type);
+  return hex;
+}
+
+
+static bool prodosCatalog(Volume* v, Title* title) {                            // volume directory from block 2
+  v->format = IMG_PRODOS;
+  v->decoded = 0;
+  const uint8_t* key = block(v, 2);
+  if (key[0] || key[1] || key[4] >> 4 != 0xF || key[0x23] != 0x27 || key[0x24] != 0x0D)
+    return false;
+
+  title->system = "ProDOS";
+  title->volume = "/" + name(key + 5, key[4] & 0x0F);
+  int b = 2;
+  for (int count = 0; count < 64 && b >= 2 && b < 280; count++) {
+    const uint8_t* blk = block(v, b);
+    for (int i = b == 2 ? 1 : 0; i < 13; i++) {                                 // the volume header is the first entry
+      const uint8_t* entry = blk + 4 + i * 0x27;
+      if (!(entry[0] >> 4)) continue;                                           // deleted
+      char hex[4], line[48];
+      snprintf(line, sizeof(line), "%c%-15s %s %5d", entry[0x1E] & 0x02 ? ' ' : '*',  // locked if not writable
+               name(entry + 1, entry[0] & 0x0F).c_str(), prodosType(entry[0x10], hex), entry[0x13] | entry[0x14] << 8);
+      title->files.push_back(line);
+    }
+    b = blk[2] | blk[3] << 8;
+  }
+  return true;
+}
+
+
+static int imageFormat(const char* path) {                                      // from the extension, -1 if not an image
+  const char* dot = strrchr(path, '.');
+  if (!dot || strlen(dot) > 4) return -1;
+  char ext[4] = { 0 };
+  for (int i = 0; dot[i + 1]; i++) ext[i] = tolower(dot[i + 1]);
+  if (!strcmp(ext, "nib")) return IMG_NIB;
+  if (!strcmp(ext, "dsk") || !strcmp(ext, "do")) return IMG_DOS;
+  if (!strcmp(ext, "po")) return IMG_PRODOS;
+  return -1;
+}
+
+
+bool Library::catalog(const char* path, Title* title) {                         // false if neither DOS 3.3 nor ProDOS
+  title->system.clear();
+  title->volume.clear();
+  title->files.clear();
+
+  int format = imageFormat(path);
+  FILE* f = fopen(path, "rb");
+  if (format < 0 || !f) {
+    if (f) fclose(f);
+    return false;
+  }
+  std::vector<uint8_t> file(NIB_SIZE + 1);
+  size_t size = fread(file.data(), 1, file.size(), f);
+  fclose(f);
+
+  Volume* v = new Volume();
+  std::vector<uint8_t> nibbles(NIB_SIZE);
+  v->nibbles = nibbles.data();
+  if (format == IMG_NIB && size == NIB_SIZE)
+    memcpy(nibbles.data(), file.data(), NIB_SIZE);
+  else if (format != IMG_NIB && size == DSK_SIZE)
+    Disk::nibblize(file.data(), nibbles.data(), format);                        // read back as any other floppy
+  else {
+    delete v;
+    return false;
+  }
+
+  bool found = dosCatalog(v, title);
+  if (!found) {
+    memset(v->image, 0, sizeof(v->image));
+    found = prodosCatalog(v, title);
+  }
+  delete v;
+  return found;
+}
+
+
+//==================================================================== SCANNER
+
+void Library::scan(const std::string& folder) {
+  stop();
+  scanning = true;
+  thread = std::thread(&Library::run, this, folder);
+}
+
+
+void Library::stop() {                                                          // the index is left as it was
+  quit = true;
+  if (thread.joinable()) thread.join();
+  quit = false;
+}
+
+
+void Library::wait() {
+  if (thread.joinable()) thread.join();
+}
+
+
+static bool byPath(const Title& a, const Title& b) {
+  return a.path < b.path;
+}
+
+
+void Library::run(std::string folder) {
+  std::unordered_map<std::string, Title> known;                                 // as indexed, unless the folder changed
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (root == folder)
+      for (const Title& title : titles) known[title.path] = title;
+    else {
+      titles.clear();
+      root = folder;
+      changes++;
+    }
+  }
+
+  std::vector<Title> found;
+  std::error_code error;
+  auto options = std::filesystem::directory_options::skip_permission_denied;
+  std::filesystem::recursive_directory_iterator it(folder, options, error), end;
+  for (; !error && it != end; it.increment(error)) {
+    if (quit) {
+      scanning = false;
+      return;
+    }
+    std::error_code fileError;
+    std::string path = it->path().string();
+    if (!it->is_regular_file(fileError) || imageFormat(path.c_str()) < 0
+        || path.find_first_of("\t\r\n") != std::string::npos)                  // can't be in the index
+      continue;
+
+    Title title;
+    title.path = path;
+    title.size = (long long int)it->file_size(fileError);
+    title.time = (long long int)it->last_write_time(fileError).time_since_epoch().count();
+    auto previous = known.find(path);
+    if (previous != known.end() && previous->second.size == title.size && previous->second.time == title.time) {
+      found.push_back(previous->second);                                        // unchanged
+      continue;
+    }
+
+    catalog(path.c_str(), &title);
+    found.push_back(title);
+    std::lock_guard<std::mutex> guard(lock);                                    // shown while the scan goes on
+    auto at = std::lower_bound(titles.begin(), titles.end(), title, byPath);
+    if (at != titles.end() && at->path == path) *at = title;
+    else titles.insert(at, title);
+    changes++;
+  }
+
+  if (error) {                                                                  // folder gone, keep the titles as they are
+    scanning = false;
+    return;
+  }
+
+  std::sort(found.begin(), found.end(), byPath);
+  {
+    std::lock_guard<std::mutex> guard(lock);                                    // without the images removed since
+    titles = found;
+    changes++;
+  }
+  save(LIBRARY_FILE);
+  scanning = false;
+}
+
+
+std::string Library::folder() {
+  std::lock_guard<std::mutex> guard(lock);
+  return root;
+}
+
+
+bool Library::latest(std::vector<Title>* copy, unsigned int* version) {        // from the GUI thread
+  if (changes == *version) return false;
+  std::lock_guard<std::mutex> guard(lock);
+  *copy = titles;
+  *version = changes;
+  return true;
+}
+
+
+//====================================================================== FILES
+
+// a text file : a header line, the folder, then each image followed by the
+// entries of its catalog, tab separated
+
+int Library::save(const char* path) {
+  std::vector<Title> copy;
+  std::string folder;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    copy = titles;
+    folder = root;
+  }
+
+  std::string temp = std::string(path) + ".tmp";                                // renamed over it once complete
+  FILE* f = fopen(temp.c_str(), "w");
+  if (!f) return 0;
+  fprintf(f, "reinette library %d\nfolder\t%s\n", LIBRARY_VERSION, folder.c_str());
+  for (const Title& title : copy) {
+    fprintf(f, "image\t%lld\t%lld\t%s\t%s\t%s\n", title.size, title.time,
+            title.system.c_str(), title.volume.c_str(), title.path.c_str());
+    for (const std::string& file : title.files)
+      fprintf(f, "file\t%s\n", file.c_str());
+  }
+  bool ok = !ferror(f);
+  ok = fclose(f) == 0 && ok;
+  std::error_code error;
+  if (ok) std::filesystem::rename(temp, path, error);
+  if (!ok || error) {
+    remove(temp.c_str());
+    return 0;
+  }
+  return 1;
+}
+
+
+int Library::load(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) return 0;
+
+  char line[4096];
+  int version = 0;
+  if (!fgets(line, sizeof(line), f) || sscanf(line, "reinette library %d", &version) != 1
+      || version != LIBRARY_VERSION) {
+    fclose(f);
+    return 0;
+  }
+
+  std::vector<Title> loaded;
+  std::string folder;
+  while (fgets(line, sizeof(line), f)) {
+    line[strcspn(line, "\r\n")] = 0;
+    char* fields[6];                                                            // tab separated
+    int count = 0;
+    for (char* p = line; count < 6; count++) {
+      fields[count] = p;
+      if (!(p = strchr(p, '\t'))) {
+        count++;
+        break;
+      }
+      *p++ = 0;
+    }
+    if (!strcmp(fields[0], "folder") && count == 2)
+      folder = fields[1];
+    else if (!strcmp(fields[0], "image") && count == 6) {
+      Title title;
+      title.size = strtoll(fields[1], NULL, 10);
+      title.time = strtoll(fields[2], NULL, 10);
+      title.system = fields[3];
+      title.volume = fields[4];
+      title.path = fields[5];
+      loaded.push_back(title);
+    }
+    else if (!strcmp(fields[0], "file") && count == 2 && !loaded.empty())
+      loaded.back().files.push_back(fields[1]);
+  }
+  fclose(f);
+
+  std::sort(loaded.begin(), loaded.end(), byPath);
+  std::lock_guard<std::mutex> guard(lock);
+  titles = loaded;
+  root = folder;
+  changes++;
+  return 1;
+}
@@ -0,0 +1,80 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __LIBRARY_H__
+#define __LIBRARY_H__
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+// floppy library : the images found under a folder, with the catalog of their
+// DOS 3.3 or ProDOS volume, read from the nibbles without running the machine.
+// A thread scans the folder, decoding only the images that changed since the
+// index was written, so the list is there as soon as the index is loaded.
+
+#define LIBRARY_FILE    "reinette.library"                                      // the index, a text file
+#define LIBRARY_VERSION 1
+
+typedef struct Title_t {
+  std::string path;                                                             // of the image
+  long long int size;
+  long long int time;                                                           // last modified, as indexed
+  std::string system;                                                           // "DOS 3.3", "ProDOS", or empty if unknown
+  std::string volume;
+  std::vector<std::string> files;                                               // as the CATALOG command lists them
+} Title;
+
+class Library {
+public:
+  std::atomic<bool> scanning;
+
+  Library();
+  ~Library();
+
+  int  load(const char* path);                                                  // the index written last time
+  int  save(const char* path);
+  void scan(const std::string& folder);                                         // in the background, then saves the index
+  void stop();
+  void wait();                                                                  // for the scan to complete
+  std::string folder();                                                         // the one scanned
+  bool latest(std::vector<Title>* copy, unsigned int* version);                 // true if changed since version
+
+  static bool catalog(const char* path, Title* title);                          // reads the volume of one image
+
+private:
+  std::mutex lock;                                                              // on the titles and the folder
+  std::vector<Title> titles;
+  std::string root;
+  std::atomic<unsigned int> changes;
+  std::atomic<bool> quit;
+  std::thread thread;
+
+  void run(std::string folder);
+};
+
+#endif
@@ -32,6 +32,8 @@ int   volume  = 10;
 bool  running = true;
 bool  paused  = false;
 float speed   = 1.023f;
+bool  turbo   = false;
+float mhz     = 0.0f;
 
 // instanciate all objects, calling their respective constructors
 Mmu*       mmu     = new Mmu();
@@ -40,44 +42,36 @@ Video*     video   = new Video();
 Disk*      disk    = new Disk();
 Speaker*   speaker = new Speaker();
 Paddles*   paddles = new Paddles();
+Heatmap*   heatmap = new Heatmap();
+#ifdef TRACE
+Trace*     trace   = new Trace();
+#endif
+Core*      core    = new Core();                                                // before the Gui, which reads its frames
 Gui*       gui     = new Gui();
+Rewind*    history = new Rewind();
+Journal*   journal = new Journal();
+Library*   library = new Library();
 
 
 int main(int argc, char *argv[]) {
 
   cpu->RST();
-  if (argc > 1) disk->load(argv[1], 0);                                         // load .nib in parameter into drive 0
-  uint8_t tries = 0;                                                            // for disk ][ speed-up
+  if (argc > 1) disk->load(argv[1], 0);                                         // load the floppy in parameter into drive 0
 
-  // main loop
-  while (running) {
+  core->start();                                                                // the emulation runs on its own thread
+  if (library->load(LIBRARY_FILE) && !library->folder().empty())
+    library->scan(library->folder());                                           // catch up with the changes, in the background
 
+  // main loop, the GUI at the display refresh rate
+  while (running) {
     gui->getInputs();
-    paddles->update();
     gui->newFrame();
-
-    if (!paused) {
-      // dirty hack - fix soon TODO - a better VERTBLANK ... - won't work when stepping through instructions
-      mmu->VERTBLANK = true;
-      cpu->exec((unsigned long long int)(1000000.0 * speed / gui->fps*0.1f));   // the apple II is clocked at 1023000.0 Hhz
-      mmu->VERTBLANK = false;
-      cpu->exec((unsigned long long int)(1000000.0 * speed / gui->fps*0.9f));   // the apple II is clocked at 1023000.0 Hhz
-
-      while (disk->unit[disk->curDrv].motorOn && ++tries)                       // until motor is off or i reaches 255+1=0
-        cpu->exec(5000);                                                        // speed up drive access artificially
-      video->update();                                                          // won't update the video if paused
-    }
-    else if (cpu->state == step) {                                              // paused and user pressed debugNumber
-      cpu->exec(1);
-      cpu->state = run;                                                         // still paused
-      video->update();                                                          // update the video after each instruction ...
-    }
-
     gui->update();
     gui->render();
-
   }  // while (running)
 
+  core->stop();
+  library->stop();
   return 0;
   // at this point all destructors were called, properly closing open files and releasing other ressources
 }
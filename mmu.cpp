@@ -27,32 +27,31 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "reinette.h"
 
 //========================================== MEMORY MAPPED SOFT SWITCHES HANDLER
 
 uint8_t Mmu::softSwitches(uint16_t address, uint8_t value, bool WRT) {
-  static uint8_t dLatch = 0;                                                    // disk ][ I/O register
-
   switch (address) {
 
     // MEMORY MANAGEMENT (and KEYBOARD)
-    case 0xC000: if (WRT) STORE80    = false; else return KBD; break;           // cause PAGE2 on to select AUX -- KEYBOARD return key code - if hi-bit is set the key code (7 lo-bits) is valid
-    case 0xC001: if (WRT) STORE80    = true;  break;                            // allow PAGE2 to switch MAIN / AUX
-    case 0xC002: if (WRT) RAMRD      = false; break;                            // read from MAIN
-    case 0xC003: if (WRT) RAMRD      = true;  break;                            // read from AUX
-    case 0xC004: if (WRT) RAMWRT     = false; break;                            // write to MAIN
-    case 0xC005: if (WRT) RAMWRT     = true;  break;                            // write to AUX
-    case 0xC006: if (WRT) INTCXROM   = false; break;                            // set peripheral roms for peripherals ($C100-$CFFF)
-    case 0xC007: if (WRT) INTCXROM   = true;  break;                            // set internal rom for peripherals ($C100-$CFFF)
-    case 0xC008: if (WRT) ALTZP      = false; break;                            // MAIN stack & rero page
-    case 0xC009: if (WRT) ALTZP      = true;  break;                            // AUX stack & rero page
-    case 0xC00A: if (WRT) SLOTC3ROM  = false; break;                            // ROM in Slot 3
-    case 0xC00B: if (WRT) SLOTC3ROM  = true;  break;                            // ROM in AUX Slot
-    case 0xC00C: if (WRT) COL80      = false; break;                            // 80 COL OFF -> 40 COL
-    case 0xC00D: if (WRT) COL80      = true;  break;                            // 80 COL ON
-    case 0xC00E: if (WRT) ALTCHARSET = false; break;                            // primary character set
-    case 0xC00F: if (WRT) ALTCHARSET = true;  break;                            // alternate character set
+    case 0xC000: if (WRT) { STORE80   = false; mapRam(); video->setMode(); } else return KBD; break;  // cause PAGE2 on to select AUX -- KEYBOARD return key code - if hi-bit is set the key code (7 lo-bits) is valid
+    case 0xC001: if (WRT) { STORE80   = true;  mapRam(); video->setMode(); } break;  // allow PAGE2 to switch MAIN / AUX
+    case 0xC002: if (WRT) { RAMRD     = false; mapRam(); } break;               // read from MAIN
+    case 0xC003: if (WRT) { RAMRD     = true;  mapRam(); } break;               // read from AUX
+    case 0xC004: if (WRT) { RAMWRT    = false; mapRam(); } break;               // write to MAIN
+    case 0xC005: if (WRT) { RAMWRT    = true;  mapRam(); } break;               // write to AUX
+    case 0xC006: if (WRT) { INTCXROM  = false; mapRom(); } break;               // set peripheral roms for peripherals ($C100-$CFFF)
+    case 0xC007: if (WRT) { INTCXROM  = true;  mapRom(); } break;               // set internal rom for peripherals ($C100-$CFFF)
+    case 0xC008: if (WRT && ALTZP) { ALTZP = false; mapZp(); mapLgc(); } break; // MAIN stack & rero page
+    case 0xC009: if (WRT && !ALTZP) { ALTZP = true; mapZp(); mapLgc(); } break; // AUX stack & rero page
+    case 0xC00A: if (WRT) { SLOTC3ROM = false; mapRom(); } break;               // ROM in Slot 3
+    case 0xC00B: if (WRT) { SLOTC3ROM = true;  mapRom(); } break;               // ROM in AUX Slot
+    case 0xC00C: if (WRT) { COL80      = false; video->setMode(); } break;      // 80 COL OFF -> 40 COL
+    case 0xC00D: if (WRT) { COL80      = true;  video->setMode(); } break;      // 80 COL ON
+    case 0xC00E: if (WRT) { ALTCHARSET = false; video->setMode(); } break;      // primary character set
+    case 0xC00F: if (WRT) { ALTCHARSET = true;  video->setMode(); } break;      // alternate character set
     case 0xC010: KBD &= 0x7F;  return KBD;                                       // KBDSTROBE, clear hi-bit and return key code
 
     // SOFT SWITCH STATUS FLAGS
@@ -64,7 +63,7 @@ uint8_t Mmu::softSwitches(uint16_t address, uint8_t value, bool WRT) {
     case 0xC016: return (0x80 * ALTZP);                                         // 0x80 if using stack and zero page from AUX
     case 0xC017: return (0x80 * SLOTC3ROM);
     case 0xC018: return (0x80 * STORE80);                                       // do we store 80 col page 2 on MAIN or AUX
-    case 0xC019: return (0x80 * VERTBLANK);
+    case 0xC019: return (0x80 * !video->inVBL());                               // RDVBLBAR, bit 7 is off during vertical blank
 
     case 0xC01A: return (0x80 * TEXT);                                          // read text switch
     case 0xC01B: return (0x80 * MIXED);                                         // read mixed switch
@@ -76,20 +75,24 @@ uint8_t Mmu::softSwitches(uint16_t address, uint8_t value, bool WRT) {
     // SOUND
     case 0xC020:                                                                // TAPEOUT (shall we listen it ? - try SAVE from applesoft)
     case 0xC030:                                                                // SPEAKER
-    case 0xC033: speaker->play(); break;                                        // apple invader uses $C033 to output sound !
+    case 0xC033:                                                                // apple invader uses $C033 to output sound !
+#ifndef HEADLESS
+      speaker->play();
+#endif
+      break;
 
     // GAME I/O STROBE OUT
     case 0xC040: break;
 
     // VIDEO MODES
-    case 0xC050: TEXT = false;  video->clearCache(); break;                     // set Graphics
-    case 0xC051: TEXT = true;   video->clearCache(); break;                     // set Text
-    case 0xC052: MIXED = false; video->clearCache(); break;                     // set Mixed to off
-    case 0xC053: MIXED = true;  video->clearCache(); break;                     // set Mixed to on
-    case 0xC054: PAGE2 = false; video->clearCache(); break;                     // select page 1
-    case 0xC055: PAGE2 = true;  video->clearCache(); break;                     // select page 2
-    case 0xC056: HIRES = false; video->clearCache(); break;                     // set HiRes to off
-    case 0xC057: HIRES = true;  video->clearCache(); break;                     // set HiRes to on
+    case 0xC050: TEXT = false;  video->setMode(); break;                        // set Graphics
+    case 0xC051: TEXT = true;   video->setMode(); break;                        // set Text
+    case 0xC052: MIXED = false; video->setMode(); break;                        // set Mixed to off
+    case 0xC053: MIXED = true;  video->setMode(); break;                        // set Mixed to on
+    case 0xC054: PAGE2 = false; video->setMode(); mapRam(); break;              // select page 1
+    case 0xC055: PAGE2 = true;  video->setMode(); mapRam(); break;              // select page 2
+    case 0xC056: HIRES = false; video->setMode(); mapRam(); break;              // set HiRes to off
+    case 0xC057: HIRES = true;  video->setMode(); mapRam(); break;              // set HiRes to on
 
     // ANNUNCIATORS
     case 0xC058: if (!IOUDIS) AN0 = false; break;                               // If IOUDIS off: Annunciator 0 Off
@@ -98,8 +101,8 @@ uint8_t Mmu::softSwitches(uint16_t address, uint8_t value, bool WRT) {
     case 0xC05B: if (!IOUDIS) AN1 = true;  break;                               // If IOUDIS off: Annunciator 1 On
     case 0xC05C: if (!IOUDIS) AN2 = false; break;                               // If IOUDIS off: Annunciator 2 Off
     case 0xC05D: if (!IOUDIS) AN2 = true;  break;                               // If IOUDIS off: Annunciator 2 On
-    case 0xC05E: if (!IOUDIS) AN3 = false; DHIRES = true;  break;               // If IOUDIS off: Annunciator 3 Off
-    case 0xC05F: if (!IOUDIS) AN3 = true;  DHIRES = false; break;               // If IOUDIS off: Annunciator 2 On
+    case 0xC05E: if (!IOUDIS) AN3 = false; DHIRES = true;  video->setMode(); break;  // If IOUDIS off: Annunciator 3 Off
+    case 0xC05F: if (!IOUDIS) AN3 = true;  DHIRES = false; video->setMode(); break;  // If IOUDIS off: Annunciator 2 On
 
     // TAPE
     case 0xC060: break;                                                         // TAPE IN
@@ -120,21 +123,21 @@ uint8_t Mmu::softSwitches(uint16_t address, uint8_t value, bool WRT) {
 
     // LANGUAGE CARD (used with MAIN and AUX)
     case 0xC080:
-    case 0xC084: LCBK2 = 1; LCRD = 1; LCWR = 0;      LCWFF = 0;    break;       // LC2RD
+    case 0xC084: setLgc(1, 1, 0, 0);                   break;                   // LC2RD
     case 0xC081:
-    case 0xC085: LCBK2 = 1; LCRD = 0; LCWR |= LCWFF; LCWFF = !WRT; break;       // LC2WR
+    case 0xC085: setLgc(1, 0, LCWR || LCWFF, !WRT);    break;                   // LC2WR
     case 0xC082:
-    case 0xC086: LCBK2 = 1; LCRD = 0; LCWR = 0;      LCWFF = 0;    break;       // ROMONLY2
+    case 0xC086: setLgc(1, 0, 0, 0);                   break;                   // ROMONLY2
     case 0xC083:
-    case 0xC087: LCBK2 = 1; LCRD = 1; LCWR |= LCWFF; LCWFF = !WRT; break;       // LC2RW
+    case 0xC087: setLgc(1, 1, LCWR || LCWFF, !WRT);    break;                   // LC2RW
     case 0xC088:
-    case 0xC08C: LCBK2 = 0; LCRD = 1; LCWR = 0;      LCWFF = 0;    break;       // LC1RD
+    case 0xC08C: setLgc(0, 1, 0, 0);                   break;                   // LC1RD
     case 0xC089:
-    case 0xC08D: LCBK2 = 0; LCRD = 0; LCWR |= LCWFF; LCWFF = !WRT; break;       // LC1WR
+    case 0xC08D: setLgc(0, 0, LCWR || LCWFF, !WRT);    break;                   // LC1WR
     case 0xC08A:
-    case 0xC08E: LCBK2 = 0; LCRD = 0; LCWR = 0;      LCWFF = 0;    break;       // ROMONLY1
+    case 0xC08E: setLgc(0, 0, 0, 0);                   break;                   // ROMONLY1
     case 0xC08B:
-    case 0xC08F: LCBK2 = 0; LCRD = 1; LCWR |= LCWFF; LCWFF = !WRT; break;       // LC1RW
+    case 0xC08F: setLgc(0, 1, LCWR || LCWFF, !WRT);    break;                   // LC1RW
 
     // SLOT 1
     case 0xC090 ... 0xC09F: break;
@@ -158,11 +161,10 @@ uint8_t Mmu::softSwitches(uint16_t address, uint8_t value, bool WRT) {
     case 0xC0EA: disk->setDrv(0); break;                                        // DRIVE0EN
     case 0xC0EB: disk->setDrv(1); break;                                        // DRIVE1EN
     case 0xC0EC:                                                                // Shift Data Latch
-      if (disk->unit[disk->curDrv].writeMode)                                   // writting
-        disk->unit[disk->curDrv].data[disk->unit[disk->curDrv].track * 0x1A00 + disk->unit[disk->curDrv].nibble] = dLatch;  // good luck gcc
-      else                                                                      // reading
-        dLatch = disk->unit[disk->curDrv].data[disk->unit[disk->curDrv].track * 0x1A00 + disk->unit[disk->curDrv].nibble];  // easy peasy
-      disk->unit[disk->curDrv].nibble = (disk->unit[disk->curDrv].nibble + 1) % 0x1A00;  // turn floppy of 1 nibble
+      if (disk->unit[disk->curDrv].format == IMG_WOZ)                           // bit streams, at the pace of cpu->ticks
+        return disk->readWoz();
+      if (disk->unit[disk->curDrv].writeMode) disk->writeNib(dLatch);           // writting
+      else dLatch = disk->readNib();                                            // reading
       return dLatch;
     case 0xC0ED: dLatch = value; break;                                         // Load Data Latch
     case 0xC0EE:                                                                // latch for READ
@@ -177,162 +179,127 @@ uint8_t Mmu::softSwitches(uint16_t address, uint8_t value, bool WRT) {
   return cpu->ticks%256;                                                        // catch all, gives a floating value
 }
 
-//================================================================== MEMORY READ
+//=================================================================== PAGE TABLES
+
+// each 256 bytes page of the address space points directly to the memory it is
+// currently mapped to. NULL pages ($C0xx, $CFxx and write protected areas) are
+// handled by readIO() and writeIO(). Tables are rebuilt by the soft switches.
+// The cpu accesses the zero page and the stack ($0000-$01FF) through zeroPage,
+// bypassing the tables : they are never I/O, nor read by the video.
+
+void Mmu::mapRam() {                                                            // $0200-$BFFF
+  for (int page = 0x02; page < 0xC0; page++) {
+    bool rdAux = RAMRD;
+    bool wrAux = RAMWRT;
+    if (STORE80 && page >= 0x04 && page < 0x08)                                 // TEXT PAGE 1 in AUX or MAIN
+      rdAux = wrAux = PAGE2;
+    else if (STORE80 && page >= 0x20 && page < 0x40)                            // HIRES PAGE 1 in AUX or MAIN
+      rdAux = wrAux = PAGE2 && HIRES;
+
+    readPages[page]  = (rdAux ? aux : ram) + (page << 8);
+    readBank[page]   = rdAux ? AUX_BANK : MAIN_BANK;
+    writePages[page] = (wrAux ? aux : ram) + (page << 8);
+    writeBank[page]  = wrAux ? AUX_BANK : MAIN_BANK;
+  }
+}
 
-uint8_t Mmu::readMem(uint16_t address) {
 
-  switch (address) {
-    case 0x0000 ... 0x01FF:                                                     // STACK and Zero Page in AUX or MAIN
-      if (ALTZP) {
-        video->auxHeatmap[address] |= 0xFF00FF00;
-        return aux[address];
-      }
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return ram[address];
-    break;
+void Mmu::mapZp() {                                                             // $0000-$01FF, STACK and Zero Page in AUX or MAIN
+  for (int page = 0x00; page < 0x02; page++) {
+    readPages[page]  = writePages[page] = (ALTZP ? aux : ram) + (page << 8);
+    readBank[page]   = writeBank[page]  = ALTZP ? AUX_BANK : MAIN_BANK;
+  }
+  zeroPage = ALTZP ? aux : ram;                                                 // refreshed with $C008/$C009
+  zeroBank = ALTZP ? AUX_BANK : MAIN_BANK;
+}
 
-    case 0x0200 ... 0x03FF:                                                     // MAIN or AUX
-      if (RAMRD) {
-        video->auxHeatmap[address] |= 0xFF00FF00;
-        return aux[address];
-      }
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return ram[address];
-    break;
 
-    case 0x0400 ... 0x07FF:                                                     // TEXT PAGE 1 in AUX or MAIN
-      if (STORE80) {
-         if (PAGE2) {
-          video->auxHeatmap[address] |= 0xFF00FF00;
-          return aux[address];
-        }
-        video->ramHeatmap[address] |= 0xFF00FF00;
-        return ram[address];
-      }
-      if (RAMRD) {
-        video->auxHeatmap[address] |= 0xFF00FF00;
-        return aux[address];
-      }
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return ram[address];
-    break;
+void Mmu::mapRom() {                                                            // $C000-$CFFF
+  uint8_t* slots[8] = { NULL, sl1, sl2, sl3, sl4, sl5, sl6, sl7 };
+
+  for (int page = 0xC0; page < 0xD0; page++) {
+    if (page >= 0xC1 && page <= 0xC7) {                                         // SLOTS ROM or ROM
+      if (INTCXROM || (page == 0xC3 && !SLOTC3ROM))                             // slot 3 : video
+        readPages[page] = rom + ((page << 8) - ROMSTART);
+      else
+        readPages[page] = slots[page & 0x07];
+    }
+    else if (page >= 0xC8 && page <= 0xCE) {                                    // SHARED EXANSION SLOTS ROM AREA or ROM
+      if (INTCXROM || !SLOTC3ROM)
+        readPages[page] = rom + ((page << 8) - ROMSTART);
+      else
+        readPages[page] = slrom[((page << 8) & 0x0F00) >> 2 & 0xF] + ((page << 8) - SLROMSTART);
+    }
+    else readPages[page] = NULL;                                                // $C0xx soft switches and $CFxx
+    readBank[page]   = MAIN_BANK;
+    writePages[page] = NULL;                                                    // readonly area
+    writeBank[page]  = MAIN_BANK;
+  }
+}
 
-    case 0x0800 ... 0x0BFF:                                                     // TEXT PAGE 2 in AUX or MAIN
-      if (RAMRD) {
-        video->auxHeatmap[address] |= 0xFF00FF00;
-        return aux[address];
-      }
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return ram[address];
-    break;
 
-    case 0x0C00 ... 0x1FFF:                                                     // AUX or MAIN
-      if (RAMRD) {
-        video->auxHeatmap[address] |= 0xFF00FF00;
-        return aux[address];
-      }
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return ram[address];
-    break;
+void Mmu::mapLgc() {                                                            // $D000-$FFFF
+  for (int page = 0xD0; page <= 0xFF; page++) {
+    uint8_t* bank;
+    if (LCBK2 && page < 0xE0)
+      bank = (ALTZP ? auxbk2 : rambk2) + ((page << 8) - BK2START);              // AUX or MAIN Bank 2
+    else
+      bank = (ALTZP ? auxlgc : ramlgc) + ((page << 8) - LGCSTART);              // AUX or MAIN Bank 1
 
-    case 0x2000 ... 0x3FFF:                                                     // HIRES PAGE 1
-      if (STORE80) {
-        if (PAGE2 && HIRES) {
-          video->auxHeatmap[address] |= 0xFF00FF00;
-          return aux[address];
-        }
-        video->ramHeatmap[address] |= 0xFF00FF00;
-        return ram[address];
-      }
-      if (RAMRD) {
-        video->auxHeatmap[address] |= 0xFF00FF00;
-        return aux[address];
-      }
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return ram[address];
-    break;
+    readPages[page]  = LCRD ? bank : rom + ((page << 8) - ROMSTART);
+    readBank[page]   = LCRD && ALTZP ? AUX_BANK : MAIN_BANK;
+    writePages[page] = LCWR ? bank : NULL;
+    writeBank[page]  = ALTZP ? AUX_BANK : MAIN_BANK;
+  }
+}
 
-    case 0x4000 ... 0x5FFF:                                                     // HIRES PAGE 2 in AUX or MAIN
-      if (RAMRD) {
-        video->auxHeatmap[address] |= 0xFF00FF00;
-        return aux[address];
-      }
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return ram[address];
-    break;
 
-    case 0x6000 ... 0xBFFF:                                                     // AUX or MAIN
-      if (RAMRD) {
-        video->auxHeatmap[address] |= 0xFF00FF00;
-        return aux[address];
-      }
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return ram[address];
-    break;
+void Mmu::setLgc(bool bank2, bool readable, bool writable, bool preWrite) {
+  LCWFF = preWrite;
+  if (bank2 == LCBK2 && readable == LCRD && writable == LCWR) return;           // same banking, same tables
+  LCBK2 = bank2;
+  LCRD  = readable;
+  LCWR  = writable;
+  mapLgc();
+}
 
-    case 0xC000 ... 0xC0FF:                                                     // SOFT SWITCHES
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return softSwitches(address, 0, false);
-    break;
 
-    case 0xC100 ... 0xC1FF:                                                     // SLOT 1 ROM or ROM
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      if (INTCXROM) {
-        return rom[address - ROMSTART];
-      }
-      return sl1[address - SL1START];
-    break;
+void Mmu::mapPages() {
+  mapZp();
+  mapRam();
+  mapRom();
+  mapLgc();
+}
 
-    case 0xC200 ... 0xC2FF:                                                     // SLOT 2 ROM or ROM
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      if (INTCXROM) {
-        return rom[address - ROMSTART];
-      }
-      return sl2[address - SL2START];
-    break;
+//================================================================== MEMORY READ
 
-    case 0xC300 ... 0xC3FF:                                                     // SLOT 3 ROM  or ROM : video
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      if (INTCXROM || !SLOTC3ROM) {
-        return rom[address - ROMSTART];
-      }
-      return sl3[address - SL3START];
-    break;
+uint8_t Mmu::readMem(uint16_t address) {
+  const uint8_t page = address >> 8;
 
-    case 0xC400 ... 0xC4FF:                                                     // SLOT 4 ROM or ROM
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      if (INTCXROM) {
-        return rom[address - ROMSTART];
-      }
-      return sl4[address - SL4START];
-    break;
+  if (readPages[page]) {
+#ifdef HEATMAP
+    heatmap->read(readBank[page], address);
+#endif
+    return readPages[page][address & 0xFF];
+  }
+  return readIO(address);
+}
 
-    case 0xC500 ... 0xC5FF:                                                     // SLOT 5 ROM or ROM
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      if (INTCXROM) {
-        return rom[address - ROMSTART];
-      }
-      return sl5[address - SL5START];
-    break;
 
-    case 0xC600 ... 0xC6FF:                                                     // SLOT 6 ROM : DISK ][ or ROM
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      if (INTCXROM) {
-        return rom[address - ROMSTART];
-      }
-      return sl6[address - SL6START];
-    break;
+uint8_t Mmu::readIO(uint16_t address) {
 
-    case 0xC700 ... 0xC7FF:                                                     // SLOT 7 ROM or ROM
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      if (INTCXROM) {
-        return rom[address - ROMSTART];
-      }
-      return sl7[address - SL7START];
+  switch (address) {
+    case 0xC000 ... 0xC0FF:                                                     // SOFT SWITCHES
+#ifdef HEATMAP
+      heatmap->read(MAIN_BANK, address);
+#endif
+      return softSwitches(address, 0, false);
     break;
 
-    case 0xC800 ... 0xCFFE:                                                     // SHARED EXANSION SLOTS ROM AREA or ROM
-      video->ramHeatmap[address] |= 0xFF00FF00;
+    case 0xCF00 ... 0xCFFE:                                                     // SHARED EXANSION SLOTS ROM AREA or ROM
+#ifdef HEATMAP
+      heatmap->read(MAIN_BANK, address);
+#endif
       if (INTCXROM || !SLOTC3ROM) {
         return rom[address - ROMSTART];
       }
@@ -343,40 +310,6 @@ uint8_t Mmu::readMem(uint16_t address) {
       disk->unit[disk->curDrv].motorOn = false;
       return 0;
     break;
-
-    case 0xD000 ... 0xDFFF:                                                     // ROM, MAIN-BK1, RAM-BK2, AUX-BK1 or AUX-BK2
-      if (LCRD) {
-        if (LCBK2) {
-          if (ALTZP) {
-            video->auxHeatmap[address] |= 0xFF00FF00;
-            return auxbk2[address - BK2START];                                  // AUX Bank 2
-          }
-          video->ramHeatmap[address] |= 0xFF00FF00;
-          return rambk2[address - BK2START];                                    // MAIN Bank 2
-        }
-        if (ALTZP) {
-          video->auxHeatmap[address] |= 0xFF00FF00;
-          return auxlgc[address - LGCSTART];                                    // AUX Bank 1
-        }
-        video->ramHeatmap[address] |= 0xFF00FF00;
-        return ramlgc[address - LGCSTART];                                      // MAIN Bank 1
-      }
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return rom[address - ROMSTART];                                           // ROM
-    break;
-
-    case 0xE000 ... 0xFFFF:                                                     // ROM, MAIN-BK1  or AUX-BK1
-      if (LCRD) {
-        if (ALTZP) {
-          video->auxHeatmap[address] |= 0xFF00FF00;
-          return auxlgc[address - LGCSTART];                                    // AUX Bank 1
-        }
-        video->ramHeatmap[address] |= 0xFF00FF00;
-        return ramlgc[address - LGCSTART];                                      // MAIN Bank 1
-      }
-      video->ramHeatmap[address] |= 0xFF00FF00;
-      return rom[address - ROMSTART];                                           // ROM
-    break;
   }
   return cpu->ticks%256;                                                        // returns a floating value
 }
@@ -385,119 +318,28 @@ uint8_t Mmu::readMem(uint16_t address) {
 //================================================================= MEMORY WRITE
 
 void Mmu::writeMem(uint16_t address, uint8_t value) {
+  const uint8_t page = address >> 8;
+
+  if (writePages[page]) {
+#ifdef HEATMAP
+    heatmap->write(writeBank[page], address);
+#endif
+    writePages[page][address & 0xFF] = value;
+    videoDirty[writeBank[page]][address >> 7] = 1;                              // the video only redraws changed lines
+    return;
+  }
+  writeIO(address, value);
+}
 
-  switch (address) {
-    case 0x0000 ... 0x01FF:                                                     // STACK and Zero Page in AUX or MAIN
-      if (ALTZP) {
-        video->auxHeatmap[address] |= 0xFF0000FF;
-        aux[address] = value;
-        return;
-      }
-      video->ramHeatmap[address] |= 0xFF0000FF;
-      ram[address] = value;
-      return;
-    break;
-
-    case 0x0200 ... 0x03FF:                                                     // MAIN or AUX
-      if (RAMWRT) {
-        video->auxHeatmap[address] |= 0xFF0000FF;
-        aux[address] = value;
-        return;
-      }
-      video->ramHeatmap[address] |= 0xFF0000FF;
-      ram[address] = value;
-      return;
-    break;
-
-    case 0x0400 ... 0x07FF:                                                     // TEXT PAGE 1 in AUX or MAIN
-      if (STORE80) {
-        if (PAGE2) {
-          video->auxHeatmap[address] |= 0xFF0000FF;
-          aux[address] = value;
-          return;
-        }
-        video->ramHeatmap[address] |= 0xFF0000FF;
-        ram[address] = value;
-        return;
-      }
-      if (RAMWRT) {
-        video->auxHeatmap[address] |= 0xFF0000FF;
-        aux[address] = value;
-        return;
-      }
-      video->ramHeatmap[address] |= 0xFF0000FF;
-      ram[address] = value;
-      return;
-    break;
-
-    case 0x0800 ... 0x0BFF:                                                     // TEXT PAGE 2 in AUX or MAIN
-      if (RAMWRT) {
-        video->auxHeatmap[address] |= 0xFF0000FF;
-        aux[address] = value;
-        return;
-      }
-      video->ramHeatmap[address] |= 0xFF0000FF;
-      ram[address] = value;
-      return;
-    break;
-
-    case 0x0C00 ... 0x1FFF:                                                     // MAIN or AUX
-      if (RAMWRT) {
-        video->auxHeatmap[address] |= 0xFF0000FF;
-        aux[address] = value;
-        return;
-      }
-      video->ramHeatmap[address] |= 0xFF0000FF;
-      ram[address] = value;
-      return;
-    break;
-
-    case 0x2000 ... 0x3FFF:                                                     // HIRES PAGE 1
-      if (STORE80) {
-        if (PAGE2 && HIRES) {
-          video->auxHeatmap[address] |= 0xFF0000FF;
-          aux[address] = value;
-          return;
-        }
-        video->ramHeatmap[address] |= 0xFF0000FF;
-        ram[address] = value;
-        return;
-      }
-      if (RAMWRT) {
-        video->auxHeatmap[address] |= 0xFF0000FF;
-        aux[address] = value;
-        return;
-      }
-      video->ramHeatmap[address] |= 0xFF0000FF;
-      ram[address] = value;
-      return;
-    break;
 
-    case 0x4000 ... 0x5FFF:                                                     // HIRES PAGE 2 in AUX or MAIN
-      if (RAMWRT) {
-        video->auxHeatmap[address] |= 0xFF0000FF;
-        aux[address] = value;
-        return;
-      }
-      video->ramHeatmap[address] |= 0xFF0000FF;
-      ram[address] = value;
-      return;
-    break;
-
-    case 0x6000 ... 0xBFFF:                                                     // AUX or MAIN
-      if (RAMWRT) {
-        video->auxHeatmap[address] |= 0xFF0000FF;
-        aux[address] = value;
-        return;
-      }
-      video->ramHeatmap[address] |= 0xFF0000FF;
-      ram[address] = value;
-      return;
-    break;
+void Mmu::writeIO(uint16_t address, uint8_t value) {
 
+  switch (address) {
     case 0xC000 ... 0xC0FF:                                                     // softSwitches
-      video->ramHeatmap[address] |= 0xFF0000FF;
-      softSwitches(address, 0, true);
+#ifdef HEATMAP
+      heatmap->write(MAIN_BANK, address);
+#endif
+      softSwitches(address, value, true);                                       // the disk ][ data latch needs it
       return;
     break;
 
@@ -510,43 +352,10 @@ void Mmu::writeMem(uint16_t address, uint8_t value) {
       return;
     break;
 
-    case 0xD000 ... 0xDFFF:                                                     // ROM, MAIN-BK1, RAM-BK2, AUX-BK1 or AUX-BK2
-      if (LCWR) {
-        if (LCBK2) {
-          if (ALTZP) {
-            video->auxHeatmap[address] |= 0xFF0000FF;
-            auxbk2[address - BK2START] = value;                                 // AUX Bank 2
-            return;
-          }
-          video->ramHeatmap[address] |= 0xFF0000FF;
-          rambk2[address - BK2START] = value;                                   // MAIN Bank 2
-          return;
-        }
-        if (ALTZP) {
-          video->auxHeatmap[address] |= 0xFF0000FF;
-          auxlgc[address - LGCSTART] = value;                                   // AUX Bank 1
-          return;
-        }
-        video->ramHeatmap[address] |= 0xFF0000FF;
-        ramlgc[address - LGCSTART] = value;                                     // MAIN Bank 1
-        return;
-      }
-      video->ramHeatmap[address] |= 0xFF0000FF;
-      return;
-    break;
-
-    case 0xE000 ... 0xFFFF:                                                     // ROM, MAIN-BK1  or AUX-BK1
-      if (LCWR) {
-        if (ALTZP) {
-          video->auxHeatmap[address] |= 0xFF0000FF;
-          auxlgc[address - LGCSTART] = value;                                   // AUX Bank 1
-          return;
-        }
-        video->ramHeatmap[address] |= 0xFF0000FF;
-        ramlgc[address - LGCSTART] = value;                                     // MAIN Bank 1
-        return;
-      }
-      video->ramHeatmap[address] |= 0xFF0000FF;
+    case 0xD000 ... 0xFFFF:                                                     // Language Card write protected : ROM
+#ifdef HEATMAP
+      heatmap->write(MAIN_BANK, address);
+#endif
       return;
     break;
   }
@@ -569,6 +378,7 @@ Mmu::Mmu() {
   fread(sl6, 1, 256, f);
   fclose(f);
 
+  dLatch = 0;                                                                   // disk ][ I/O register
   init();
 }
 
@@ -605,7 +415,6 @@ void Mmu::init() {
   SLOTC3ROM = false;                                                            // use AUX Slot rom
 
   IOUDIS = false;
-  VERTBLANK = true;
 
   memset(ram,    0, sizeof(ram));                                               // 48K of MAIN in $000-$BFFF
   memset(aux,    0, sizeof(aux));                                               // 48K of AUX memory
@@ -613,8 +422,54 @@ void Mmu::init() {
   memset(rambk2, 0, sizeof(rambk2));                                            // MAIN bank 2 of Language Card 4K in $D000-$DFFF
   memset(auxlgc, 0, sizeof(auxlgc));                                            // AUX Language Card 12K in $D000-$FFFF
   memset(auxbk2, 0, sizeof(auxbk2));                                            // AUX bank 2 of Language Card 4K in $D000-$DFFF
+  memset(videoDirty, 1, sizeof(videoDirty));                                    // all of the screen has to be drawn
+
+  mapPages();                                                                   // build the read and write page tables
 
   // dirty hacks - fix when I know why
   ram[0x4D] = 0xAA;                                                             // Joust won't work if this memory location equals zero
   ram[0xD0] = 0xAA;                                                             // Planetoids won't work if this memory location equals zero
 }
+
+
+void Mmu::saveState(State* s) {                                                 // RAM and soft switches, not the ROMs
+  s->begin("MMU ");
+  s->put(ram,    sizeof(ram));
+  s->put(ramlgc, sizeof(ramlgc));
+  s->put(rambk2, sizeof(rambk2));
+  s->put(aux,    sizeof(aux));
+  s->put(auxlgc, sizeof(auxlgc));
+  s->put(auxbk2, sizeof(auxbk2));
+  s->put(KBD);
+  s->put(dLatch);
+  uint8_t switches[] = { PAGE2, TEXT, MIXED, HIRES, DHIRES, COL80, ALTCHARSET,
+                         LCWR, LCRD, LCBK2, LCWFF, AN0, AN1, AN2, AN3,
+                         RAMRD, RAMWRT, ALTZP, STORE80, INTCXROM, SLOTC3ROM, IOUDIS };
+  s->put(switches);
+  s->end();
+}
+
+
+void Mmu::loadState(State* s) {
+  s->open("MMU ");
+  s->get(ram,    sizeof(ram));
+  s->get(ramlgc, sizeof(ramlgc));
+  s->get(rambk2, sizeof(rambk2));
+  s->get(aux,    sizeof(aux));
+  s->get(auxlgc, sizeof(auxlgc));
+  s->get(auxbk2, sizeof(auxbk2));
+  s->get(KBD);
+  s->get(dLatch);
+  bool* switches[] = { &PAGE2, &TEXT, &MIXED, &HIRES, &DHIRES, &COL80, &ALTCHARSET,
+                       &LCWR, &LCRD, &LCBK2, &LCWFF, &AN0, &AN1, &AN2, &AN3,
+                       &RAMRD, &RAMWRT, &ALTZP, &STORE80, &INTCXROM, &SLOTC3ROM, &IOUDIS };
+  for (bool* b : switches) {
+    uint8_t value;
+    s->get(value);
+    *b = value != 0;
+  }
+  s->close();
+
+  mapPages();                                                                   // page tables follow the restored switches
+  memset(videoDirty, 1, sizeof(videoDirty));                                    // all of the screen has to be drawn
+}
@@ -120,15 +120,37 @@ public:
   bool INTCXROM;
   bool SLOTC3ROM;
   bool IOUDIS;
-  bool VERTBLANK;
+
+  uint8_t* readPages[256];        // memory currently mapped to each page for reads, NULL for I/O
+  uint8_t* writePages[256];       // memory currently mapped to each page for writes, NULL for I/O or ROM
+  uint8_t readBank[256];          // page is read from MAIN_BANK or AUX_BANK (for the heatmaps)
+  uint8_t writeBank[256];         // page is written to MAIN_BANK or AUX_BANK (for the heatmaps and the video)
+  uint8_t* zeroPage;              // $0000-$01FF, zero page and stack from MAIN or AUX (ALTZP), used directly by the cpu
+  uint8_t zeroBank;               // zero page and stack bank, MAIN_BANK or AUX_BANK (for the heatmaps)
+  uint8_t videoDirty[2][512];     // 128 bytes blocks written since the last video update, per bank
+  uint8_t dLatch;                 // disk ][ I/O register
 
   Mmu();
   ~Mmu();
   void init();
+  void mapPages();                // rebuild the page tables from the soft switches
+  void saveState(State* state);
+  void loadState(State* state);
   uint8_t readMem(uint16_t address);
   void writeMem(uint16_t address, uint8_t value);
+  inline uint8_t peek(uint16_t address) {                                       // without side effects, 0 for I/O
+    const uint8_t* page = readPages[address >> 8];
+    return page ? page[address & 0xFF] : 0;
+  }
 
 private:
+  void mapRam();
+  void mapZp();
+  void mapRom();
+  void mapLgc();
+  void setLgc(bool bank2, bool readable, bool writable, bool preWrite);         // remaps only on a change
+  uint8_t readIO(uint16_t address);
+  void writeIO(uint16_t address, uint8_t value);
   uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT);
 };
 
@@ -67,3 +67,31 @@ void Paddles::update() {
     }
   }
 }
+
+
+void Paddles::saveState(State* s) {                                             // buttons, sticks and countdowns
+  s->begin("PADL");
+  s->put(PB0); s->put(PB1); s->put(PB2);
+  s->put(GCP);
+  s->put(GCC);
+  s->put(GCD);
+  s->put(GCA);
+  s->put(GCActionSpeed);
+  s->put(GCReleaseSpeed);
+  s->put(GCCrigger);
+  s->end();
+}
+
+
+void Paddles::loadState(State* s) {
+  s->open("PADL");
+  s->get(PB0); s->get(PB1); s->get(PB2);
+  s->get(GCP);
+  s->get(GCC);
+  s->get(GCD);
+  s->get(GCA);
+  s->get(GCActionSpeed);
+  s->get(GCReleaseSpeed);
+  s->get(GCCrigger);
+  s->close();
+}
@@ -48,6 +48,9 @@ public:
   void reset();
   void update();
   uint8_t read(int pdl);
+
+  void saveState(State* state);
+  void loadState(State* state);
 };
 
 #endif
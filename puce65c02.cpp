@@ -31,6 +31,7 @@
   https://github.com/ArthurFerreira2/puce65c02
 */
 
+#include <cstring>
 #include "reinette.h"  // provides mmu->readMem and mmu->writeMem
 
 
@@ -48,12 +49,9 @@ void puce65c02::IRQ() {
   state = run;                    // always ?
   if (!P.bits.I) return;          // consume 0 clock cycle ?
   PC++;
-  mmu->writeMem(0x100 + SP, (PC >> 8) & 0xFF);
-  SP--;
-  mmu->writeMem(0x100 + SP, PC & 0xFF);
-  SP--;
-  mmu->writeMem(0x100 + SP, P.byte & ~BREAK);
-  SP--;
+  push(PC >> 8);
+  push(PC & 0xFF);
+  push(getP() & ~BREAK);
   PC = mmu->readMem(0xFFFE) | (mmu->readMem(0xFFFF) << 8);
   ticks += 7;
 }
@@ -63,12 +61,9 @@ void puce65c02::NMI() {
   state = run;
   P.bits.I = 1;  // ???
   PC++;
-  mmu->writeMem(0x100 + SP, (PC >> 8) & 0xFF);
-  SP--;
-  mmu->writeMem(0x100 + SP, PC & 0xFF);
-  SP--;
-  mmu->writeMem(0x100 + SP, P.byte & ~BREAK);
-  SP--;
+  push(PC >> 8);
+  push(PC & 0xFF);
+  push(getP() & ~BREAK);
   PC = mmu->readMem(0xFFFA) | (mmu->readMem(0xFFFB) << 8);
   ticks += 7;
 }
@@ -76,6 +71,7 @@ void puce65c02::NMI() {
 
 puce65c02::puce65c02() {
   ticks = 0LL;
+  setP(0);
 }
 
 
@@ -89,6 +85,30 @@ void puce65c02::setPC(uint16_t address) {
 }
 
 
+void puce65c02::saveState(State* s) {
+  s->begin("CPU ");
+  s->put(PC);
+  s->put(A); s->put(X); s->put(Y); s->put(SP); s->put(getP());
+  s->put(ticks);
+  s->put((uint8_t)state);
+  s->end();
+}
+
+
+void puce65c02::loadState(State* s) {
+  uint8_t st;
+  s->open("CPU ");
+  s->get(PC);
+  uint8_t p;
+  s->get(A); s->get(X); s->get(Y); s->get(SP); s->get(p);
+  setP(p);
+  s->get(ticks);
+  s->get(st);
+  state = (status)st;
+  s->close();
+}
+
+
 /*
   Addressing modes abreviations used in the comments below :
 
@@ -111,2451 +131,1576 @@ void puce65c02::setPC(uint16_t address) {
 */
 
 
+/*
+  Building blocks of the opcode handlers. An addressing mode (Mode) gives the
+  effective address, an operation (Op) works on the value found there, and
+  load, modify and store compose both for a given opcode. They are templates,
+  so that each handler is fully specialised and inlined by the compiler.
+
+  With penalty, ABX, ABY and IZY add the extra cycle taken when indexing
+  crosses a page. Loads always pay it, read-modify-write shifts do, stores and
+  INC/DEC don't.
+
+  The zero page modes, the indirect pointers and the stack never reach I/O :
+  they read and write the bank selected by ALTZP directly (mmu->zeroPage).
+*/
+
+inline uint8_t puce65c02::read(uint16_t address) {
+  return mmu->readMem(address);
+}
+
+inline void puce65c02::write(uint16_t address, uint8_t value) {
+  mmu->writeMem(address, value);
+}
+
+inline uint8_t puce65c02::readZP(uint8_t address) {  // zero page, bypassing the MMU
+#ifdef HEATMAP
+  heatmap->read(mmu->zeroBank, address);
+#endif
+  return mmu->zeroPage[address];
+}
+
+inline void puce65c02::writeZP(uint8_t address, uint8_t value) {
+#ifdef HEATMAP
+  heatmap->write(mmu->zeroBank, address);
+#endif
+  mmu->zeroPage[address] = value;
+}
+
+template <puce65c02::Mode M>
+inline uint8_t puce65c02::readAt(uint16_t address) {  // operand of a zero page mode, or anywhere
+  if constexpr (M == ZPG || M == ZPX || M == ZPY) return readZP(address);
+  else return read(address);
+}
+
+template <puce65c02::Mode M>
+inline void puce65c02::writeAt(uint16_t address, uint8_t value) {
+  if constexpr (M == ZPG || M == ZPX || M == ZPY) writeZP(address, value);
+  else write(address, value);
+}
+
+inline uint8_t puce65c02::fetch() {
+  return read(PC++);
+}
+
+inline uint16_t puce65c02::fetch16() {
+  uint16_t address = fetch();
+  return address | (fetch() << 8);
+}
+
+inline void puce65c02::push(uint8_t value) {  // the stack, like the zero page, bypasses the MMU
+#ifdef HEATMAP
+  heatmap->write(mmu->zeroBank, 0x100 + SP);
+#endif
+  mmu->zeroPage[0x100 + SP] = value;
+  SP--;
+}
+
+inline uint8_t puce65c02::pull() {
+  SP++;
+#ifdef HEATMAP
+  heatmap->read(mmu->zeroBank, 0x100 + SP);
+#endif
+  return mmu->zeroPage[0x100 + SP];
+}
+
+inline uint8_t puce65c02::getP() {  // N and Z are only derived when P is read
+  return (P.byte & ~(SIGN | ZERO)) | (lastN & SIGN) | (lastZ ? 0 : ZERO);
+}
+
+inline void puce65c02::setP(uint8_t value) {
+  P.byte = value;
+  lastN = value;
+  lastZ = ~value & ZERO;
+}
+
+inline void puce65c02::setNZ(uint8_t value) {
+  lastN = lastZ = value;
+}
+
+inline void puce65c02::add(uint8_t value) {  // ADC, and SBC with the value complemented
+  uint16_t result = A + value + P.bits.C;
+  P.bits.V = ((result ^ A) & (result ^ value) & 0x0080) != 0;
+  if (P.bits.D)
+    result += ((((result + 0x66) ^ A ^ value) >> 3) & 0x22) * 3;
+  P.bits.C = result > 0xFF;
+  A = result & 0xFF;
+  setNZ(A);
+}
+
+inline void puce65c02::compare(uint8_t reg, uint8_t value) {
+  setNZ(reg - value);
+  P.bits.C = reg >= value;
+}
+
+inline void puce65c02::jump(uint8_t offset) {  // branch taken
+  uint16_t address = offset;
+  ticks++;
+  if (address & SIGN)
+    address |= 0xFF00;  // jump backward
+  if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
+    ticks++;
+  PC += address;
+}
+
+template <puce65c02::Mode M, bool penalty>
+inline uint16_t puce65c02::address() {
+  if constexpr (M == IMM) return PC++;
+  if constexpr (M == ZPG) return fetch();
+  if constexpr (M == ZPX) return (uint8_t)(fetch() + X);  // 8bit -> zp wrap around
+  if constexpr (M == ZPY) return (uint8_t)(fetch() + Y);
+  if constexpr (M == ABS) return fetch16();
+  if constexpr (M == ABX || M == ABY) {
+    uint16_t address = fetch16();
+    uint8_t index = M == ABX ? X : Y;
+    if (penalty && ((address & 0xFF) + index) > 0xFF)  // page crossing
+      ticks++;
+    return address + index;
+  }
+  if constexpr (M == IZP || M == IZX || M == IZY) {
+    uint8_t pointer = M == IZX ? fetch() + X : fetch();
+    uint16_t address = readZP(pointer);
+    pointer++;
+    address |= readZP(pointer) << 8;
+    if constexpr (M == IZY) {
+      if (penalty && ((address & 0xFF) + Y) > 0xFF)  // page crossing
+        ticks++;
+      address += Y;
+    }
+    return address;
+  }
+}
+
+template <puce65c02::Op O>
+inline void puce65c02::operate(uint8_t value) {
+  if constexpr (O == ORA) setNZ(A |= value);
+  if constexpr (O == AND) setNZ(A &= value);
+  if constexpr (O == EOR) setNZ(A ^= value);
+  if constexpr (O == ADC) add(value);
+  if constexpr (O == SBC) add(P.bits.D ? (value ^ 0xFF) - 0x66 : value ^ 0xFF);
+  if constexpr (O == CMP) compare(A, value);
+  if constexpr (O == CPX) compare(X, value);
+  if constexpr (O == CPY) compare(Y, value);
+  if constexpr (O == LDA) setNZ(A = value);
+  if constexpr (O == LDX) setNZ(X = value);
+  if constexpr (O == LDY) setNZ(Y = value);
+  if constexpr (O == BIT) {
+    lastZ = A & value;
+    lastN = value;
+    P.bits.V = (value & OFLOW) != 0;
+  }
+}
+
+template <puce65c02::Op O>
+inline uint8_t puce65c02::modified(uint8_t value) {
+  uint8_t result = 0;
+  if constexpr (O == ASL) { result = value << 1; P.bits.C = value >> 7; }
+  if constexpr (O == LSR) { result = value >> 1; P.bits.C = value & 1; }
+  if constexpr (O == ROL) { result = (value << 1) | P.bits.C; P.bits.C = value >> 7; }
+  if constexpr (O == ROR) { result = (value >> 1) | (P.bits.C << 7); P.bits.C = value & 1; }
+  if constexpr (O == INC) result = value + 1;
+  if constexpr (O == DEC) result = value - 1;
+  if constexpr (O == TSB || O == TRB) {
+    lastZ = value & A;
+    return O == TSB ? value | A : value & ~A;
+  }
+  setNZ(result);
+  return result;
+}
+
+template <puce65c02::Mode M, puce65c02::Op O>
+inline void puce65c02::load() {
+  operate<O>(readAt<M>(address<M, true>()));
+}
+
+template <puce65c02::Mode M, puce65c02::Op O, bool penalty>
+inline void puce65c02::modify() {
+  uint16_t address = this->address<M, penalty>();
+  writeAt<M>(address, modified<O>(readAt<M>(address)));
+}
+
+template <puce65c02::Mode M>
+inline void puce65c02::store(uint8_t value) {
+  writeAt<M>(address<M, false>(), value);
+}
+
+template <uint8_t flag, bool set>
+inline void puce65c02::branch() {
+  uint8_t offset = fetch();
+  bool taken;
+  if constexpr (flag == SIGN) taken = (lastN & SIGN) != 0;
+  else if constexpr (flag == ZERO) taken = lastZ == 0;
+  else taken = (P.byte & flag) != 0;
+  if (taken == set)
+    jump(offset);
+}
+
+template <int bit, bool set>
+inline void puce65c02::branchBit() {  // BBR and BBS
+  uint8_t value = readZP(fetch());
+  uint16_t address = fetch();
+  if (address & SIGN)
+    address |= 0xFF00;  // jump backward
+  if (((value >> bit) & 1) == set)
+    PC += address;
+}
+
+template <int bit, bool set>
+inline void puce65c02::changeBit() {  // RMB and SMB
+  uint8_t address = fetch();
+  uint8_t value = readZP(address);
+  writeZP(address, set ? value | (1 << bit) : value & ~(1 << bit));
+}
+
+
+#ifdef TRACE
+__attribute__((always_inline))  // exec() is too large for the heuristics
+inline uint8_t puce65c02::traced(TraceEntry* ring, unsigned long long int& count, uint8_t opcode) {
+  TraceEntry* e = &ring[count++ & (TRACE_SIZE - 1)];  // records the instruction about to run
+  e->ticks = ticks;
+  e->PC = PC - 1;
+  e->opcode = opcode;
+  e->regs = *static_cast<Registers*>(this);
+  return opcode;
+}
+#define FETCH      traced(traceRing, traceCount, mmu->readMem(PC++))
+#else
+#define FETCH      mmu->readMem(PC++)
+#endif
+
+
+/*
+  Two dispatch modes, selected at build time :
+
+  by default a switch in a while loop, checking the cycle count and the cpu
+  state before each instruction.
+
+  with THREADED defined (GCC and Clang labels as values), each handler fetches
+  the next opcode and jumps straight to its handler through a table of label
+  addresses. The cpu state is only checked on entry, as only STP and WAI can
+  change it during exec() : they leave the loop (HALT).
+*/
+
+#ifdef THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"  // computed gotos are an extension
+#define OPCODE(op) op_##op
+#define NEXT       if (ticks < cycleCount) goto *dispatch[FETCH]; goto done
+#define HALT       goto done
+#define ROW(h)     &&op_0x##h##0, &&op_0x##h##1, &&op_0x##h##2, &&op_0x##h##3, \
+                   &&op_0x##h##4, &&op_0x##h##5, &&op_0x##h##6, &&op_0x##h##7, \
+                   &&op_0x##h##8, &&op_0x##h##9, &&op_0x##h##A, &&op_0x##h##B, \
+                   &&op_0x##h##C, &&op_0x##h##D, &&op_0x##h##E, &&op_0x##h##F
+#else
+#define OPCODE(op) case op
+#define NEXT       break
+#define HALT       break
+#endif
+
 uint16_t puce65c02::exec(unsigned long long int cycleCount) {
   cycleCount += ticks;  // cycleCount becomes the targeted ticks value8
-  while (ticks < cycleCount && (state == run || state == step)) {
 
-      uint8_t value8;
-      uint16_t value16;
-      uint16_t address;
+  uint16_t address;
+#ifdef TRACE
+  TraceEntry* const traceRing = trace->entries;  // in registers while exec() runs,
+  unsigned long long int traceCount = trace->count;  // given back to the Trace when it returns
+#endif
+
+#ifdef THREADED
+  static const void* const dispatch[256] = {
+    ROW(0), ROW(1), ROW(2), ROW(3), ROW(4), ROW(5), ROW(6), ROW(7),
+    ROW(8), ROW(9), ROW(A), ROW(B), ROW(C), ROW(D), ROW(E), ROW(F)
+  };
+
+  if (state != run && state != step) return PC;
+  NEXT;  // fetch the first instruction and increment Program Counter
+#else
+  while (ticks < cycleCount && (state == run || state == step)) {
 
-      switch(mmu->readMem(PC++)) {  // fetch instruction and increment Program Counter
+      switch(FETCH) {  // fetch instruction and increment Program Counter
+#endif
 
-        case 0x00 :  // IMP BRK
+        OPCODE(0x00) :  // IMP BRK
           PC++;
-          mmu->writeMem(0x100 + SP, ((PC) >> 8) & 0xFF);
-          SP--;
-          mmu->writeMem(0x100 + SP, PC & 0xFF);
-          SP--;
-          mmu->writeMem(0x100 + SP, P.byte | BREAK);
-          SP--;
+          push(PC >> 8);
+          push(PC & 0xFF);
+          push(getP() | BREAK);
           P.bits.I = 1;
           P.bits.D = 0;
-          PC = mmu->readMem(0xFFFE) | (mmu->readMem(0xFFFF) << 8);
+          PC = read(0xFFFE) | (read(0xFFFF) << 8);
           ticks += 7;
-        break;
+        NEXT;
 
-        case 0x01 :  // IZX ORA
-          value8 = mmu->readMem(PC) + X;
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          A |= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x01) :  // IZX ORA
+          load<IZX, ORA>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x02 :  // IMM NOP
+        OPCODE(0x02) :  // IMM NOP
           PC++;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x03 :  // IMP NOP
+        OPCODE(0x03) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x04 :  // ZPG TSB
-          address = mmu->readMem(PC);
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = (value8 & A) == 0;
-          mmu->writeMem(address, value8 | A);
+        OPCODE(0x04) :  // ZPG TSB
+          modify<ZPG, TSB>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x05 :  // ZPG ORA
-          A |= mmu->readMem(mmu->readMem(PC));
-          PC++;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x05) :  // ZPG ORA
+          load<ZPG, ORA>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x06 :  // ZPG ASL
-          address = mmu->readMem(PC);
-          PC++;
-          value16 = mmu->readMem(address) << 1;
-          P.bits.C = value16 > 0xFF;
-          value16 &= 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
+        OPCODE(0x06) :  // ZPG ASL
+          modify<ZPG, ASL>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x07 :  // ZPG RMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) & ~1);
+        OPCODE(0x07) :  // ZPG RMB
+          changeBit<0, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x08 :  // IMP PHP
-          mmu->writeMem(0x100 + SP, P.byte | BREAK);
-          SP--;
+        OPCODE(0x08) :  // IMP PHP
+          push(getP() | BREAK);
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x09 :  // IMM ORA
-          A |= mmu->readMem(PC);
-          PC++;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x09) :  // IMM ORA
+          load<IMM, ORA>();
           ticks += 2;
-        break;
-
-        case 0x0A :  // ACC ASL
-          value16 = A << 1;
-          A = value16 & 0xFF;
-          P.bits.C = value16 > 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        NEXT;
+
+        OPCODE(0x0A) :  // ACC ASL
+          A = modified<ASL>(A);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x0B :  // IMP NOP
+        OPCODE(0x0B) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x0C :  // ABS TSB
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = (value8 & A) == 0;
-          mmu->writeMem(address, value8 | A);
+        OPCODE(0x0C) :  // ABS TSB
+          modify<ABS, TSB>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x0D :  // ABS ORA
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          A |= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x0D) :  // ABS ORA
+          load<ABS, ORA>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x0E :  // ABS ASL
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value16 = mmu->readMem(address) << 1;
-          P.bits.C = value16 > 0xFF;
-          value16 &= 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
+        OPCODE(0x0E) :  // ABS ASL
+          modify<ABS, ASL>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x0F :  // ZPR BBR
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (!(value8 & 1))
-            PC += address;
+        OPCODE(0x0F) :  // ZPR BBR
+          branchBit<0, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x10 :  // REL BPL
-          address = mmu->readMem(PC);
-          PC++;
-          if (!P.bits.S) {  // jump taken
-            ticks++;
-            if (address & SIGN)
-              address |= 0xFF00;  // jump backward
-            if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-              ticks++;
-            PC += address;
-          }
+        OPCODE(0x10) :  // REL BPL
+          branch<SIGN, false>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x11 :  // IZY ORA
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          ticks += (((address & 0xFF) + Y) & 0xFF00) ? 6 : 5;  // page crossing
-          address += Y;
-          A |= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0x12 :  // IZP ORA
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          A |= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x11) :  // IZY ORA
+          load<IZY, ORA>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x13 :  // IMP NOP
+        OPCODE(0x12) :  // IZP ORA
+          load<IZP, ORA>();
+          ticks += 5;
+        NEXT;
+
+        OPCODE(0x13) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x14 :  // ZPG TRB
-          address = mmu->readMem(PC);
-          PC++;
-          value8 = mmu->readMem(address);
-          mmu->writeMem(address, value8 & ~A);
-          P.bits.Z = (value8 & A) == 0;
+        OPCODE(0x14) :  // ZPG TRB
+          modify<ZPG, TRB>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x15 :  // ZPX ORA
-          A |= mmu->readMem(mmu->readMem(PC) + X);
-          PC++;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x15) :  // ZPX ORA
+          load<ZPX, ORA>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x16 :  // ZPX ASL
-          address = mmu->readMem(PC) + X;
-          PC++;
-          value16 = mmu->readMem(address) << 1;
-          mmu->writeMem(address, value16 & 0xFF);
-          P.bits.C = value16 > 0xFF;
-          P.bits.Z = value16 == 0;
-          P.bits.S = (value16 & 0xFF) > 0x7F;
+        OPCODE(0x16) :  // ZPX ASL
+          modify<ZPX, ASL>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x17 :  // ZPG RMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) & ~2);
+        OPCODE(0x17) :  // ZPG RMB
+          changeBit<1, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x18 :  // IMP CLC
+        OPCODE(0x18) :  // IMP CLC
           P.bits.C = 0;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x19 :  // ABY ORA
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += Y;
-          A |= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0x1A :  // ACC INC
-          A++;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x19) :  // ABY ORA
+          load<ABY, ORA>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0x1A) :  // ACC INC
+          A = modified<INC>(A);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x1B :  // IMP NOP
+        OPCODE(0x1B) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x1C :  // ABS TRB
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = (value8 & A) == 0;
-          mmu->writeMem(address, value8 & ~A);
+        OPCODE(0x1C) :  // ABS TRB
+          modify<ABS, TRB>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x1D :  // ABX ORA
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          A |= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0x1E :  // ABX ASL
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += address + X > 0xFF ? 7 : 6;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          value16 = mmu->readMem(address) << 1;
-          P.bits.C = value16 > 0xFF;
-          value16 &= 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
-        break;
-
-        case 0x1F :  // ZPR BBR
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (!(value8 & 2))
-            PC += address;
+        OPCODE(0x1D) :  // ABX ORA
+          load<ABX, ORA>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0x1E) :  // ABX ASL
+          modify<ABX, ASL, true>();
+          ticks += 6;
+        NEXT;
+
+        OPCODE(0x1F) :  // ZPR BBR
+          branchBit<1, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x20 :  // ABS JSR
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          mmu->writeMem(0x100 + SP, (PC >> 8) & 0xFF);
-          SP--;
-          mmu->writeMem(0x100 + SP, PC & 0xFF);
-          SP--;
+        OPCODE(0x20) :  // ABS JSR
+          address = fetch();
+          address |= read(PC) << 8;  // PC left on the last byte, RTS adds one
+          push(PC >> 8);
+          push(PC & 0xFF);
           PC = address;
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x21 :  // IZX AND
-          value8 = mmu->readMem(PC) + X;
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          A &= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x21) :  // IZX AND
+          load<IZX, AND>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x22 :  // IMM NOP
+        OPCODE(0x22) :  // IMM NOP
           PC++;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x23 :  // IMP NOP
+        OPCODE(0x23) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x24 :  // ZPG BIT
-          address = mmu->readMem(PC);
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = (A & value8) == 0;
-          P.byte = (P.byte & 0x3F) | (value8 & 0xC0);
+        OPCODE(0x24) :  // ZPG BIT
+          load<ZPG, BIT>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x25 :  // ZPG AND
-          A &= mmu->readMem(mmu->readMem(PC));
-          PC++;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x25) :  // ZPG AND
+          load<ZPG, AND>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x26 :  // ZPG ROL
-          address = mmu->readMem(PC);
-          PC++;
-          value16 = (mmu->readMem(address) << 1) | P.bits.C;
-          P.bits.C = (value16 & 0x100) != 0;
-          value16 &= 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
+        OPCODE(0x26) :  // ZPG ROL
+          modify<ZPG, ROL>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x27 :  // ZPG RMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) & ~4);
+        OPCODE(0x27) :  // ZPG RMB
+          changeBit<2, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x28 :  // IMP PLP
-          SP++;
-          P.byte = mmu->readMem(0x100 + SP) | UNDEF;
+        OPCODE(0x28) :  // IMP PLP
+          setP(pull() | UNDEF);
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x29 :  // IMM AND
-          A &= mmu->readMem(PC);
-          PC++;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x29) :  // IMM AND
+          load<IMM, AND>();
           ticks += 2;
-        break;
-
-        case 0x2A :  // ACC ROL
-          value16 = (A << 1) | P.bits.C;
-          P.bits.C = (value16 & 0x100) != 0;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        NEXT;
+
+        OPCODE(0x2A) :  // ACC ROL
+          A = modified<ROL>(A);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x2B :  // IMP NOP
+        OPCODE(0x2B) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x2C :  // ABS BIT
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = (A & value8) == 0;
-          P.byte = (P.byte & 0x3F) | (value8 & 0xC0);
+        OPCODE(0x2C) :  // ABS BIT
+          load<ABS, BIT>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x2D :  // ABS AND
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          A &= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x2D) :  // ABS AND
+          load<ABS, AND>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x2E :  // ABS ROL
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value16 = (mmu->readMem(address) << 1) | P.bits.C;
-          P.bits.C = (value16 & 0x100) != 0;
-          value16 &= 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
+        OPCODE(0x2E) :  // ABS ROL
+          modify<ABS, ROL>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x2F :  // ZPR BBR
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (!(value8 & 4))
-            PC += address;
+        OPCODE(0x2F) :  // ZPR BBR
+          branchBit<2, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x30 :  // REL BMI
-          address = mmu->readMem(PC);
-          PC++;
-          if (P.bits.S) {  // branch taken
-            ticks++;
-            if (address & SIGN)
-              address |= 0xFF00;  // jump backward
-            if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-              ticks++;
-            PC += address;
-          }
+        OPCODE(0x30) :  // REL BMI
+          branch<SIGN, true>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x31 :  // IZY AND
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          ticks += (((address & 0xFF) + Y) & 0xFF00) ? 6 : 5;  // page crossing
-          address += Y;
-          A &= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0x32 :  // IZP AND
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          A &= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x31) :  // IZY AND
+          load<IZY, AND>();
+          ticks += 5;
+        NEXT;
+
+        OPCODE(0x32) :  // IZP AND
+          load<IZP, AND>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x33 :  // IMP NOP
+        OPCODE(0x33) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x34 :  // ZPX BIT
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = (A & value8) == 0;
-          P.byte = (P.byte & 0x3F) | (value8 & 0xC0);
+        OPCODE(0x34) :  // ZPX BIT
+          load<ZPX, BIT>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x35 :  // ZPX AND
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          A &= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x35) :  // ZPX AND
+          load<ZPX, AND>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x36 :  // ZPX ROL
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          value16 = (mmu->readMem(address) << 1) | P.bits.C;
-          P.bits.C = value16 > 0xFF;
-          value16 &= 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
+        OPCODE(0x36) :  // ZPX ROL
+          modify<ZPX, ROL>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x37 :  // ZPG RMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) & ~8);
+        OPCODE(0x37) :  // ZPG RMB
+          changeBit<3, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x38 :  // IMP SEC
+        OPCODE(0x38) :  // IMP SEC
           P.bits.C = 1;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x39 :  // ABY AND
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += Y;
-          A &= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0x3A :  // ACC DEC
-          --A;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x39) :  // ABY AND
+          load<ABY, AND>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0x3A) :  // ACC DEC
+          A = modified<DEC>(A);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x3B :  // IMP NOP
+        OPCODE(0x3B) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x3C :  // ABX BIT
-          ticks += mmu->readMem(PC) + X > 0xFF ? 5 : 4;
-          address = mmu->readMem(PC);
-          PC++;
-          address |= (mmu->readMem(PC) << 8) + X;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = (A & value8) == 0;
-          P.byte = (P.byte & 0x3F) | (value8 & 0xC0);
-        break;
+        OPCODE(0x3C) :  // ABX BIT
+          load<ABX, BIT>();
+          ticks += 4;
+        NEXT;
 
-        case 0x3D :  // ABX AND
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          A &= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0x3E :  // ABX ROL
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += address + X > 0xFF ? 7 : 6;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          value16 = (mmu->readMem(address) << 1) | P.bits.C;
-          P.bits.C = value16 > 0xFF;
-          value16 &= 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
-        break;
-
-        case 0x3F :  // ZPR BBR
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (!(value8 & 8))
-            PC += address;
+        OPCODE(0x3D) :  // ABX AND
+          load<ABX, AND>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0x3E) :  // ABX ROL
+          modify<ABX, ROL, true>();
+          ticks += 6;
+        NEXT;
+
+        OPCODE(0x3F) :  // ZPR BBR
+          branchBit<3, false>();
           ticks += 5;
-        break;
-
-        case 0x40 :  // IMP RTI
-          SP++;
-          P.byte = mmu->readMem(0x100 + SP);
-          SP++;
-          PC = mmu->readMem(0x100 + SP);
-          SP++;
-          PC |= mmu->readMem(0x100 + SP) << 8;
+        NEXT;
+
+        OPCODE(0x40) :  // IMP RTI
+          setP(pull());
+          PC = pull();
+          PC |= pull() << 8;
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x41 :  // IZX EOR
-          value8 = mmu->readMem(PC) + X;
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          A ^= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x41) :  // IZX EOR
+          load<IZX, EOR>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x42 :  // IMM NOP
+        OPCODE(0x42) :  // IMM NOP
           PC++;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x43 :  // IMP NOP
+        OPCODE(0x43) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x44 :  // ZPG NOP
+        OPCODE(0x44) :  // ZPG NOP
           PC++;
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x45 :  // ZPG EOR
-          address = mmu->readMem(PC);
-          PC++;
-          A ^= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x45) :  // ZPG EOR
+          load<ZPG, EOR>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x46 :  // ZPG LSR
-          address = mmu->readMem(PC);
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.C = (value8 & 1) != 0;
-          value8 = value8 >> 1;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
+        OPCODE(0x46) :  // ZPG LSR
+          modify<ZPG, LSR>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x47 :  // ZPG RMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) & ~16);
+        OPCODE(0x47) :  // ZPG RMB
+          changeBit<4, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x48 :  // IMP PHA
-          mmu->writeMem(0x100 + SP, A);
-          SP--;
+        OPCODE(0x48) :  // IMP PHA
+          push(A);
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x49 :  // IMM EOR
-          A ^= mmu->readMem(PC);
-          PC++;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x49) :  // IMM EOR
+          load<IMM, EOR>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x4A :  // ACC LSR
-          P.bits.C = (A & 1) != 0;
-          A = A >> 1;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x4A) :  // ACC LSR
+          A = modified<LSR>(A);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x4B :  // IMP NOP
+        OPCODE(0x4B) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x4C :  // ABS JMP
-          PC = mmu->readMem(PC) | (mmu->readMem(PC + 1) << 8);
+        OPCODE(0x4C) :  // ABS JMP
+          PC = fetch16();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x4D :  // ABS EOR
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          A ^= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x4D) :  // ABS EOR
+          load<ABS, EOR>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x4E :  // ABS LSR
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.C = (value8 & 1) != 0;
-          value8 = value8 >> 1;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
+        OPCODE(0x4E) :  // ABS LSR
+          modify<ABS, LSR>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x4F :  // ZPR BBR
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (!(value8 & 16))
-            PC += address;
+        OPCODE(0x4F) :  // ZPR BBR
+          branchBit<4, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x50 :  // REL BVC
-          address = mmu->readMem(PC);
-          PC++;
-          if (!P.bits.V) {  // branch taken
-            ticks++;
-            if (address & SIGN)
-              address |= 0xFF00;  // jump backward
-            if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-              ticks++;
-            PC += address;
-          }
+        OPCODE(0x50) :  // REL BVC
+          branch<OFLOW, false>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x51 :  // IZY EOR
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          ticks += (((address & 0xFF) + Y) & 0xFF00) ? 6 : 5;  // page crossing
-          A ^= mmu->readMem(address + Y);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0x52 :  // IZP EOR
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          A ^= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x51) :  // IZY EOR
+          load<IZY, EOR>();
+          ticks += 5;
+        NEXT;
+
+        OPCODE(0x52) :  // IZP EOR
+          load<IZP, EOR>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x53 :  // IMP NOP
+        OPCODE(0x53) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x54 :  // ZPX NOP
+        OPCODE(0x54) :  // ZPX NOP
           PC++;
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x55 :  // ZPX EOR
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          A ^= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x55) :  // ZPX EOR
+          load<ZPX, EOR>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x56 :  // ZPX LSR
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.C = (value8 & 1) != 0;
-          value8 = value8 >> 1;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
+        OPCODE(0x56) :  // ZPX LSR
+          modify<ZPX, LSR>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x57 :  // ZPG RMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) & ~32);
+        OPCODE(0x57) :  // ZPG RMB
+          changeBit<5, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x58 :  // IMP CLI
+        OPCODE(0x58) :  // IMP CLI
           P.bits.I = 0;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x59 :  // ABY EOR
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += Y;
-          A ^= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0x5A :  // IMP PHY
-          mmu->writeMem(0x100 + SP, Y);
-          SP--;
+        OPCODE(0x59) :  // ABY EOR
+          load<ABY, EOR>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0x5A) :  // IMP PHY
+          push(Y);
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x5B :  // IMP NOP
+        OPCODE(0x5B) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x5C :  // ABS NOP
+        OPCODE(0x5C) :  // ABS NOP
           PC += 2;
           ticks += 8;
-        break;
+        NEXT;
 
-        case 0x5D :  // ABX EOR
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          A ^= mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0x5E :  // ABX LSR
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += address + X > 0xFF ? 7 : 6;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          value8 = mmu->readMem(address);
-          P.bits.C = (value8 & 1) != 0;
-          value8 = value8 >> 1;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
-        break;
-
-        case 0x5F :  // ZPR BBR
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (!(value8 & 32))
-            PC += address;
+        OPCODE(0x5D) :  // ABX EOR
+          load<ABX, EOR>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0x5E) :  // ABX LSR
+          modify<ABX, LSR, true>();
+          ticks += 6;
+        NEXT;
+
+        OPCODE(0x5F) :  // ZPR BBR
+          branchBit<5, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x60 :  // IMP RTS
-          SP++;
-          PC = mmu->readMem(0x100 + SP);
-          SP++;
-          PC |= mmu->readMem(0x100 + SP) << 8;
+        OPCODE(0x60) :  // IMP RTS
+          PC = pull();
+          PC |= pull() << 8;
           PC++;
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x61 :  // IZX ADC
-          value8 = mmu->readMem(PC) + X;
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          value8 = mmu->readMem(address);
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x61) :  // IZX ADC
+          load<IZX, ADC>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x62 :  // IMM NOP
+        OPCODE(0x62) :  // IMM NOP
           PC++;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x63 :  // IMP NOP
+        OPCODE(0x63) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x64 :  // ZPG STZ
-          mmu->writeMem(mmu->readMem(PC), 0x00);
-          PC++;
+        OPCODE(0x64) :  // ZPG STZ
+          store<ZPG>(0);
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x65 :  // ZPG ADC
-          address = mmu->readMem(PC);
-          PC++;
-          value8 = mmu->readMem(address);
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x65) :  // ZPG ADC
+          load<ZPG, ADC>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x66 :  // ZPG ROR
-          address = mmu->readMem(PC);
-          PC++;
-          value8 = mmu->readMem(address);
-          value16 = (value8 >> 1) | (P.bits.C << 7);
-          P.bits.C = (value8 & 0x1) != 0;
-          value16 &= 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
+        OPCODE(0x66) :  // ZPG ROR
+          modify<ZPG, ROR>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x67 :  // ZPG RMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) & ~64);
+        OPCODE(0x67) :  // ZPG RMB
+          changeBit<6, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x68 :  // IMP PLA
-          SP++;
-          A = mmu->readMem(0x100 + SP);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x68) :  // IMP PLA
+          setNZ(A = pull());
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x69 :  // IMM ADC
-          value8 = mmu->readMem(PC);
-          PC++;
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x69) :  // IMM ADC
+          load<IMM, ADC>();
           ticks += 2;
-        break;
-
-        case 0x6A :  // ACC ROR
-          value16 = (A >> 1) | (P.bits.C << 7);
-          P.bits.C = (A & 0x1) != 0;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        NEXT;
+
+        OPCODE(0x6A) :  // ACC ROR
+          A = modified<ROR>(A);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x6B :  // IMP NOP
+        OPCODE(0x6B) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x6C :  // IND JMP
-          address = mmu->readMem(PC) | mmu->readMem(PC + 1) << 8;
-          PC = mmu->readMem(address) | (mmu->readMem(address + 1) << 8);
+        OPCODE(0x6C) :  // IND JMP
+          address = fetch16();
+          PC = read(address) | (read(address + 1) << 8);
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x6D :  // ABS ADC
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x6D) :  // ABS ADC
+          load<ABS, ADC>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x6E :  // ABS ROR
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          value16 = (value8 >> 1) | (P.bits.C << 7);
-          P.bits.C = (value8 & 0x1) != 0;
-          value16 = value16 & 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
+        OPCODE(0x6E) :  // ABS ROR
+          modify<ABS, ROR>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x6F :  // ZPR BBR
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (!(value8 & 64))
-            PC += address;
+        OPCODE(0x6F) :  // ZPR BBR
+          branchBit<6, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x70 :  // REL BVS
-          address = mmu->readMem(PC);
-          PC++;
-          if (P.bits.V) {  // branch taken
-            ticks++;
-            if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-              ticks++;
-            if (address & SIGN)
-              address |= 0xFF00;  // jump backward
-            PC += address;
-          }
+        OPCODE(0x70) :  // REL BVS
+          branch<OFLOW, true>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x71 :  // IZY ADC
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          if ((address + Y) & 0xFF00)  // page crossing
-            ticks++;
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          address += Y;
-          value8 = mmu->readMem(address);
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x71) :  // IZY ADC
+          load<IZY, ADC>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x72 :  // IZP ADC
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          value8 = mmu->readMem(address);
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x72) :  // IZP ADC
+          load<IZP, ADC>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x73 :  // IMP NOP
+        OPCODE(0x73) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x74 :  // ZPX STZ
-          value8 = mmu->readMem(PC) + X;  // 8bit -> zp wrap around
-          PC++;
-          mmu->writeMem(value8, 0x00);
+        OPCODE(0x74) :  // ZPX STZ
+          store<ZPX>(0);
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x75 :  // ZPX ADC
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          value8 = mmu->readMem(address);
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x75) :  // ZPX ADC
+          load<ZPX, ADC>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x76 :  // ZPX ROR
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          value8 = mmu->readMem(address);
-          value16 = (value8 >> 1) | (P.bits.C << 7);
-          P.bits.C = (value8 & 0x1) != 0;
-          value16 = value16 & 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
+        OPCODE(0x76) :  // ZPX ROR
+          modify<ZPX, ROR>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x77 :  // ZPG RMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) & ~128);
+        OPCODE(0x77) :  // ZPG RMB
+          changeBit<7, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x78 :  // IMP SEI
+        OPCODE(0x78) :  // IMP SEI
           P.bits.I = 1;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x79 :  // ABY ADC
-          if ((mmu->readMem(PC) + Y) & 0xFF00)
-            ticks++;
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += Y;
-          value8 = mmu->readMem(address);
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x79) :  // ABY ADC
+          load<ABY, ADC>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x7A :  // IMP PLY
-          SP++;
-          Y = mmu->readMem(0x100 + SP);
-          P.bits.Z = Y == 0;
-          P.bits.S = Y > 0x7F;
+        OPCODE(0x7A) :  // IMP PLY
+          setNZ(Y = pull());
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x7B :  // IMP NOP
+        OPCODE(0x7B) :  // IMP NOP
           ticks++;
-        break;
-
-        case 0x7C :  // IAX JMP
-          ticks += ((PC & 0xFF) + X) > 0xFF ? 7 : 6;
-          address = (mmu->readMem((PC + 1) & 0xFFFF) << 8) + mmu->readMem(PC) + X;
-          PC = (mmu->readMem(address) | (mmu->readMem((address + 1) & 0xFFFF) << 8));
-        break;
-
-        case 0x7D :  // ABX ADC
-          if ((mmu->readMem(PC) + X) & 0xFF00)
-            ticks++;
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          value8 = mmu->readMem(address);
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        NEXT;
+
+        OPCODE(0x7C) :  // IAX JMP
+          address = fetch16() + X;
+          PC = read(address) | (read(address + 1) << 8);
+          ticks += 6;
+        NEXT;
+
+        OPCODE(0x7D) :  // ABX ADC
+          load<ABX, ADC>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x7E :  // ABX ROR
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += address + X > 0xFF ? 7 : 6;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          value8 = mmu->readMem(address);
-          value16 = (value8 >> 1) | (P.bits.C << 7);
-          P.bits.C = (value8 & 0x1) != 0;
-          value16 = value16 & 0xFF;
-          mmu->writeMem(address, value16);
-          P.bits.Z = value16 == 0;
-          P.bits.S = value16 > 0x7F;
-        break;
-
-        case 0x7F :  // ZPR BBR
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (!(value8 & 128))
-            PC += address;
+        OPCODE(0x7E) :  // ABX ROR
+          modify<ABX, ROR, true>();
+          ticks += 6;
+        NEXT;
+
+        OPCODE(0x7F) :  // ZPR BBR
+          branchBit<7, false>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x80 :  // REL BRA
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          ticks += ((PC & 0xFF) + address) & 0xFF00 ? 4 : 3;
-          PC += address;
-        break;
-
-        case 0x81 :  // IZX STA
-          value8 = mmu->readMem(PC) + X;
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          mmu->writeMem(address, A);
+        OPCODE(0x80) :  // REL BRA
+          jump(fetch());
+          ticks += 2;
+        NEXT;
+
+        OPCODE(0x81) :  // IZX STA
+          store<IZX>(A);
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x82 :  // IMM NOP
+        OPCODE(0x82) :  // IMM NOP
           PC++;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x83 :  // IMP NOP
+        OPCODE(0x83) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x84 :  // ZPG STY
-          mmu->writeMem(mmu->readMem(PC), Y);
-          PC++;
+        OPCODE(0x84) :  // ZPG STY
+          store<ZPG>(Y);
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x85 :  // ZPG STA
-          mmu->writeMem(mmu->readMem(PC), A);
-          PC++;
+        OPCODE(0x85) :  // ZPG STA
+          store<ZPG>(A);
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x86 :  // ZPG STX
-          mmu->writeMem(mmu->readMem(PC), X);
-          PC++;
+        OPCODE(0x86) :  // ZPG STX
+          store<ZPG>(X);
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0x87 :  // ZPG SMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) | 1);
+        OPCODE(0x87) :  // ZPG SMB
+          changeBit<0, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x88 :  // IMP DEY
-          Y--;
-          P.bits.Z = (Y & 0xFF) == 0;
-          P.bits.S = (Y & SIGN) != 0;
+        OPCODE(0x88) :  // IMP DEY
+          setNZ(--Y);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x89 :  // IMM BIT
-          P.bits.Z = (A & mmu->readMem(PC)) == 0;
-          PC++;
+        OPCODE(0x89) :  // IMM BIT
+          lastZ = A & read(PC++);  // only Z is affected
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x8A :  // IMP TXA
-          A = X;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x8A) :  // IMP TXA
+          setNZ(A = X);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x8B :  // IMP NOP
+        OPCODE(0x8B) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x8C :  // ABS STY
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          mmu->writeMem(address, Y);
+        OPCODE(0x8C) :  // ABS STY
+          store<ABS>(Y);
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x8D :  // ABS STA
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          mmu->writeMem(address, A);
+        OPCODE(0x8D) :  // ABS STA
+          store<ABS>(A);
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x8E :  // ABS STX
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          mmu->writeMem(address, X);
+        OPCODE(0x8E) :  // ABS STX
+          store<ABS>(X);
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x8F :  // ZPR BBS
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (value8 & 1)
-            PC += address;
+        OPCODE(0x8F) :  // ZPR BBS
+          branchBit<0, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x90 :  // REL BCC
-          address = mmu->readMem(PC);
-          PC++;
-          if (!P.bits.C) {  // branch taken
-            ticks++;
-            if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-              ticks++;
-            if (address & SIGN)
-              address |= 0xFF00;  // jump backward
-            PC += address;
-          }
+        OPCODE(0x90) :  // REL BCC
+          branch<CARRY, false>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x91 :  // IZY STA
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          address += Y;
-          mmu->writeMem(address, A);
+        OPCODE(0x91) :  // IZY STA
+          store<IZY>(A);
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0x92 :  // IZP STA
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          mmu->writeMem(address, A);
+        OPCODE(0x92) :  // IZP STA
+          store<IZP>(A);
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x93 :  // IMP NOP
+        OPCODE(0x93) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x94 :  // ZPX STY
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          mmu->writeMem(address, Y);
+        OPCODE(0x94) :  // ZPX STY
+          store<ZPX>(Y);
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x95 :  // ZPX STA
-          mmu->writeMem((mmu->readMem(PC) + X) & 0xFF, A);
-          PC++;
+        OPCODE(0x95) :  // ZPX STA
+          store<ZPX>(A);
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x96 :  // ZPY STX
-          mmu->writeMem((mmu->readMem(PC) + Y) & 0xFF, X);
-          PC++;
+        OPCODE(0x96) :  // ZPY STX
+          store<ZPY>(X);
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x97 :  // ZPG SMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) | 2);
+        OPCODE(0x97) :  // ZPG SMB
+          changeBit<1, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x98 :  // IMP TYA
-          A = Y;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0x98) :  // IMP TYA
+          setNZ(A = Y);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x99 :  // ABY STA
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += Y;
-          mmu->writeMem(address, A);
+        OPCODE(0x99) :  // ABY STA
+          store<ABY>(A);
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x9A :  // IMP TXS
+        OPCODE(0x9A) :  // IMP TXS
           SP = X;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0x9B :  // IMP NOP
+        OPCODE(0x9B) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0x9C :  // ABS STZ
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          mmu->writeMem(address, 0x00);
+        OPCODE(0x9C) :  // ABS STZ
+          store<ABS>(0);
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0x9D :  // ABX STA
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          mmu->writeMem(address, A);
+        OPCODE(0x9D) :  // ABX STA
+          store<ABX>(A);
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0x9E :  // ABX STZ
-          ticks +=  mmu->readMem(PC) + X > 0xFF ? 6 : 5;
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          mmu->writeMem(address, 0x00);
-        break;
+        OPCODE(0x9E) :  // ABX STZ
+          store<ABX>(0);
+          ticks += 5;
+        NEXT;
 
-        case 0x9F :  // ZPR BBS
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (value8 & 2)
-            PC += address;
+        OPCODE(0x9F) :  // ZPR BBS
+          branchBit<1, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xA0 :  // IMM LDY
-          Y = mmu->readMem(PC);
-          PC++;
-          P.bits.Z = Y == 0;
-          P.bits.S = Y > 0x7F;
+        OPCODE(0xA0) :  // IMM LDY
+          load<IMM, LDY>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xA1 :  // IZX LDA
-          value8 = mmu->readMem(PC) + X;
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          A = mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xA1) :  // IZX LDA
+          load<IZX, LDA>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0xA2 :  // IMM LDX
-          address = PC;
-          PC++;
-          X = mmu->readMem(address);
-          P.bits.Z = X == 0;
-          P.bits.S = X > 0x7F;
+        OPCODE(0xA2) :  // IMM LDX
+          load<IMM, LDX>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xA4 :  // ZPG LDY
-          Y = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          P.bits.Z = Y == 0;
-          P.bits.S = Y > 0x7F;
+        OPCODE(0xA3) :  // IMP NOP
+          ticks++;
+        NEXT;
+
+        OPCODE(0xA4) :  // ZPG LDY
+          load<ZPG, LDY>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0xA5 :  // ZPG LDA
-          A = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xA5) :  // ZPG LDA
+          load<ZPG, LDA>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0xA6 :  // ZPG LDX
-          X = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          P.bits.Z = X == 0;
-          P.bits.S = X > 0x7F;
+        OPCODE(0xA6) :  // ZPG LDX
+          load<ZPG, LDX>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0xA7 :  // ZPG SMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) | 4);
+        OPCODE(0xA7) :  // ZPG SMB
+          changeBit<2, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xA8 :  // IMP TAY
-          Y = A;
-          P.bits.Z = Y == 0;
-          P.bits.S = Y > 0x7F;
+        OPCODE(0xA8) :  // IMP TAY
+          setNZ(Y = A);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xA9 :  // IMM LDA
-          A = mmu->readMem(PC);
-          PC++;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xA9) :  // IMM LDA
+          load<IMM, LDA>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xAA :  // IMP TAX
-          X = A;
-          P.bits.Z = X == 0;
-          P.bits.S = X > 0x7F;
+        OPCODE(0xAA) :  // IMP TAX
+          setNZ(X = A);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xAB :  // IMP NOP
+        OPCODE(0xAB) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0xAC :  // ABS LDY
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          Y = mmu->readMem(address);
-          P.bits.Z = Y == 0;
-          P.bits.S = Y > 0x7F;
+        OPCODE(0xAC) :  // ABS LDY
+          load<ABS, LDY>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xAD :  // ABS LDA
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          A = mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xAD) :  // ABS LDA
+          load<ABS, LDA>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xAE :  // ABS LDX
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          X = mmu->readMem(address);
-          P.bits.Z = X == 0;
-          P.bits.S = X > 0x7F;
+        OPCODE(0xAE) :  // ABS LDX
+          load<ABS, LDX>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xAF :  // ZPR BBS
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (value8 & 4)
-            PC += address;
+        OPCODE(0xAF) :  // ZPR BBS
+          branchBit<2, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xB0 :  // REL BCS
-          address = mmu->readMem(PC);
-          PC++;
-          if (P.bits.C) {  // branch taken
-            ticks++;
-            if (address & SIGN)
-              address |= 0xFF00;  // jump backward
-            if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-              ticks++;
-            PC += address;
-          }
+        OPCODE(0xB0) :  // REL BCS
+          branch<CARRY, true>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xB1 :  // IZY LDA
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          A = mmu->readMem(address + Y);
-          ticks += (((address & 0xFF) + Y) & 0xFF00) ? 6 : 5;  // page crossing
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0xB2 :  // IZP LDA
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          A = mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xB1) :  // IZY LDA
+          load<IZY, LDA>();
+          ticks += 5;
+        NEXT;
+
+        OPCODE(0xB2) :  // IZP LDA
+          load<IZP, LDA>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xB3 :  // IMP NOP
+        OPCODE(0xB3) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0xB4 :  // ZPX LDY
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          Y = mmu->readMem(address);
-          P.bits.Z = Y == 0;
-          P.bits.S = Y > 0x7F;
+        OPCODE(0xB4) :  // ZPX LDY
+          load<ZPX, LDY>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xB5 :  // ZPX LDA
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          A = mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xB5) :  // ZPX LDA
+          load<ZPX, LDA>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xB6 :  // ZPY LDX
-          address = (mmu->readMem(PC) + Y) & 0xFF;
-          PC++;
-          X = mmu->readMem(address);
-          P.bits.Z = X == 0;
-          P.bits.S = X > 0x7F;
+        OPCODE(0xB6) :  // ZPY LDX
+          load<ZPY, LDX>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xB7 :  // ZPG SMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) | 8);
+        OPCODE(0xB7) :  // ZPG SMB
+          changeBit<3, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xB8 :  // IMP CLV
+        OPCODE(0xB8) :  // IMP CLV
           P.bits.V = 0;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xB9 :  // ABY LDA
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += Y;
-          A = mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0xBA :  // IMP TSX
-          X = SP;
-          P.bits.Z = X == 0;
-          P.bits.S = X > 0x7F;
+        OPCODE(0xB9) :  // ABY LDA
+          load<ABY, LDA>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0xBA) :  // IMP TSX
+          setNZ(X = SP);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xBB :  // IMP NOP
+        OPCODE(0xBB) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0xBC :  // ABX LDY
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          Y = mmu->readMem(address);
-          P.bits.Z = Y == 0;
-          P.bits.S = Y > 0x7F;
-        break;
-
-        case 0xBD :  // ABX LDA
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          A = mmu->readMem(address);
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
-        break;
-
-        case 0xBE :  // ABY LDX
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += Y;
-          X = mmu->readMem(address);
-          P.bits.Z = X == 0;
-          P.bits.S = X > 0x7F;
-        break;
-
-        case 0xBF :  // ZPR BBS
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (value8 & 8)
-            PC += address;
+        OPCODE(0xBC) :  // ABX LDY
+          load<ABX, LDY>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0xBD) :  // ABX LDA
+          load<ABX, LDA>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0xBE) :  // ABY LDX
+          load<ABY, LDX>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0xBF) :  // ZPR BBS
+          branchBit<3, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xC0 :  // IMM CPY
-          value8 = mmu->readMem(PC);
-          PC++;
-          P.bits.Z = ((Y - value8) & 0xFF) == 0;
-          P.bits.S = ((Y - value8) & SIGN) != 0;
-          P.bits.C = (Y >= value8) != 0;
+        OPCODE(0xC0) :  // IMM CPY
+          load<IMM, CPY>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xC1 :  // IZX CMP
-          value8 = mmu->readMem(PC) + X;
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          value8 = mmu->readMem(address);
-          P.bits.Z = ((A - value8) & 0xFF) == 0;
-          P.bits.S = ((A - value8) & SIGN) != 0;
-          P.bits.C = (A >= value8) != 0;
+        OPCODE(0xC1) :  // IZX CMP
+          load<IZX, CMP>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0xC2 :  // IMM NOP
+        OPCODE(0xC2) :  // IMM NOP
           PC++;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xC3 :  // IMP NOP
+        OPCODE(0xC3) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0xC4 :  // ZPG CPY
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          P.bits.Z = ((Y - value8) & 0xFF) == 0;
-          P.bits.S = ((Y - value8) & SIGN) != 0;
-          P.bits.C = (Y >= value8) != 0;
+        OPCODE(0xC4) :  // ZPG CPY
+          load<ZPG, CPY>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0xC5 :  // ZPG CMP
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          P.bits.Z = ((A - value8) & 0xFF) == 0;
-          P.bits.S = ((A - value8) & SIGN) != 0;
-          P.bits.C = (A >= value8) != 0;
+        OPCODE(0xC5) :  // ZPG CMP
+          load<ZPG, CMP>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0xC6 :  // ZPG DEC
-          address = mmu->readMem(PC);
-          PC++;
-          value8 = mmu->readMem(address);
-          --value8;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
+        OPCODE(0xC6) :  // ZPG DEC
+          modify<ZPG, DEC>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xC7 :  // ZPG SMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) | 16);
+        OPCODE(0xC7) :  // ZPG SMB
+          changeBit<4, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xC8 :  // IMP INY
-          Y++;
-          P.bits.Z = Y  == 0;
-          P.bits.S = Y > 0x7F;
+        OPCODE(0xC8) :  // IMP INY
+          setNZ(++Y);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xC9 :  // IMM CMP
-          value8 = mmu->readMem(PC);
-          PC++;
-          P.bits.Z = ((A - value8) & 0xFF) == 0;
-          P.bits.S = ((A - value8) & SIGN) != 0;
-          P.bits.C = (A >= value8) != 0;
+        OPCODE(0xC9) :  // IMM CMP
+          load<IMM, CMP>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xCA :  // IMP DEX
-          X--;
-          P.bits.Z = (X & 0xFF) == 0;
-          P.bits.S = X > 0x7F;
+        OPCODE(0xCA) :  // IMP DEX
+          setNZ(--X);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xCB :  // IMP WAI
+        OPCODE(0xCB) :  // IMP WAI
           state = wait;
           ticks += 3;
-        break;
+        HALT;
 
-        case 0xCC :  // ABS CPY
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = ((Y - value8) & 0xFF) == 0;
-          P.bits.S = ((Y - value8) & SIGN) != 0;
-          P.bits.C = (Y >= value8) != 0;
+        OPCODE(0xCC) :  // ABS CPY
+          load<ABS, CPY>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xCD :  // ABS CMP
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = ((A - value8) & 0xFF) == 0;
-          P.bits.S = ((A - value8) & SIGN) != 0;
-          P.bits.C = (A >= value8) != 0;
+        OPCODE(0xCD) :  // ABS CMP
+          load<ABS, CMP>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xCE :  // ABS DEC
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          value8--;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
-          ticks += 3;
-        break;
+        OPCODE(0xCE) :  // ABS DEC
+          modify<ABS, DEC>();
+          ticks += 6;
+        NEXT;
 
-        case 0xCF :  // ZPR BBS
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (value8 & 16)
-            PC += address;
+        OPCODE(0xCF) :  // ZPR BBS
+          branchBit<4, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xD0 :  // REL BNE
-          address = mmu->readMem(PC);
-          PC++;
-          if (!P.bits.Z) {  // branch taken
-            ticks++;
-            if (address & SIGN)
-              address |= 0xFF00;  // jump backward
-            if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-              ticks++;
-            PC += address;
-          }
+        OPCODE(0xD0) :  // REL BNE
+          branch<ZERO, false>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xD1 :  // IZY CMP
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          ticks += ((address + Y) & 0xFF00) ? 6 : 5;  // page crossing
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          address += Y;
-          value8 = mmu->readMem(address);
-          P.bits.Z = ((A - value8) & 0xFF) == 0;
-          P.bits.S = ((A - value8) & SIGN) != 0;
-          P.bits.C = (A >= value8) != 0;
-        break;
-
-        case 0xD2 :  // IZP CMP
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          value8 = mmu->readMem(address);
-          P.bits.Z = ((A - value8) & 0xFF) == 0;
-          P.bits.S = ((A - value8) & SIGN) != 0;
-          P.bits.C = (A >= value8) != 0;
+        OPCODE(0xD1) :  // IZY CMP
+          load<IZY, CMP>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xD3 :  // IMP NOP
+        OPCODE(0xD2) :  // IZP CMP
+          load<IZP, CMP>();
+          ticks += 5;
+        NEXT;
+
+        OPCODE(0xD3) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0xD4 :  // ZPX NOP
+        OPCODE(0xD4) :  // ZPX NOP
           PC++;
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xD5 :  // ZPX CMP
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = ((A - value8) & 0xFF) == 0;
-          P.bits.S = ((A - value8) & SIGN) != 0;
-          P.bits.C = (A >= value8) != 0;
+        OPCODE(0xD5) :  // ZPX CMP
+          load<ZPX, CMP>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xD6 :  // ZPX DEC
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          value8 = mmu->readMem(address);
-          value8--;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
+        OPCODE(0xD6) :  // ZPX DEC
+          modify<ZPX, DEC>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0xD7 :  // ZPG SMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) | 32);
+        OPCODE(0xD7) :  // ZPG SMB
+          changeBit<5, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xD8 :  // IMP CLD
+        OPCODE(0xD8) :  // IMP CLD
           P.bits.D = 0;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xD9 :  // ABY CMP
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += Y;
-          value8 = mmu->readMem(address);
-          P.bits.Z = ((A - value8) & 0xFF) == 0;
-          P.bits.S = ((A - value8) & SIGN) != 0;
-          P.bits.C = (A >= value8) != 0;
-        break;
-
-        case 0xDA :  // IMP PHX
-          mmu->writeMem(0x100 + SP, X);
-          SP--;
+        OPCODE(0xD9) :  // ABY CMP
+          load<ABY, CMP>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0xDA) :  // IMP PHX
+          push(X);
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0xDB :  // IMP STP
+        OPCODE(0xDB) :  // IMP STP
           state = stop;
           ticks += 3;
-        break;
+        HALT;
 
-        case 0xDC :  // ABS NOP
+        OPCODE(0xDC) :  // ABS NOP
           PC += 2;
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xDD :  // ABX CMP
-          address = mmu->readMem(PC);
-          PC++;
-          ticks += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          value8 = mmu->readMem(address);
-          P.bits.Z = ((A - value8) & 0xFF) == 0;
-          P.bits.S = ((A - value8) & SIGN) != 0;
-          P.bits.C = (A >= value8) != 0;
-        break;
-
-        case 0xDE :  // ABX DEC
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          value8 = mmu->readMem(address);
-          value8--;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = (value8 & SIGN) != 0;
+        OPCODE(0xDD) :  // ABX CMP
+          load<ABX, CMP>();
+          ticks += 4;
+        NEXT;
+
+        OPCODE(0xDE) :  // ABX DEC
+          modify<ABX, DEC>();
           ticks += 7;
-        break;
+        NEXT;
 
-        case 0xDF :  // ZPR BBS
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (value8 & 32)
-            PC += address;
+        OPCODE(0xDF) :  // ZPR BBS
+          branchBit<5, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xE0 :  // IMM CPX
-          value8 = mmu->readMem(PC);
-          PC++;
-          P.bits.Z = ((X - value8) & 0xFF) == 0;
-          P.bits.S = ((X - value8) & SIGN) != 0;
-          P.bits.C = (X >= value8) != 0;
+        OPCODE(0xE0) :  // IMM CPX
+          load<IMM, CPX>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xE1 :  // IZX SBC
-          value8 = mmu->readMem(PC) + X;
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          value8 = mmu->readMem(address);
-          value8 ^= 0xFF;
-          if (P.bits.D)
-            value8 -= 0x0066;
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xE1) :  // IZX SBC
+          load<IZX, SBC>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0xE2 :  // IMM NOP
+        OPCODE(0xE2) :  // IMM NOP
           PC++;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xE3 :  // IMP NOP
+        OPCODE(0xE3) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0xE4 :  // ZPG CPX
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          P.bits.Z = ((X - value8) & 0xFF) == 0;
-          P.bits.S = ((X - value8) & SIGN) != 0;
-          P.bits.C = (X >= value8) != 0;
+        OPCODE(0xE4) :  // ZPG CPX
+          load<ZPG, CPX>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0xE5 :  // ZPG SBC
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          value8 ^= 0xFF;
-          if (P.bits.D)
-            value8 -= 0x0066;
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xE5) :  // ZPG SBC
+          load<ZPG, SBC>();
           ticks += 3;
-        break;
+        NEXT;
 
-        case 0xE6 :  // ZPG INC
-          address = mmu->readMem(PC);
-          PC++;
-          value8 = mmu->readMem(address);
-          value8++;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
+        OPCODE(0xE6) :  // ZPG INC
+          modify<ZPG, INC>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xE7 :  // ZPG SMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) | 64);
+        OPCODE(0xE7) :  // ZPG SMB
+          changeBit<6, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xE8 :  // IMP INX
-          X++;
-          P.bits.Z = X == 0;
-          P.bits.S = X > 0x7F;
+        OPCODE(0xE8) :  // IMP INX
+          setNZ(++X);
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xE9 :  // IMM SBC
-          value8 = mmu->readMem(PC);
-          PC++;
-          value8 ^= 0xFF;
-          if (P.bits.D)
-            value8 -= 0x0066;
-          value16 = A + value8 + (P.bits.C);
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xE9) :  // IMM SBC
+          load<IMM, SBC>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xEA:  // IMP NOP
+        OPCODE(0xEA) :  // IMP NOP
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xEB :  // IMP NOP
+        OPCODE(0xEB) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0xEC :  // ABS CPX
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          P.bits.Z = ((X - value8) & 0xFF) == 0;
-          P.bits.S = ((X - value8) & SIGN) != 0;
-          P.bits.C = (X >= value8) != 0;
+        OPCODE(0xEC) :  // ABS CPX
+          load<ABS, CPX>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xED :  // ABS SBC
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          value8 ^= 0xFF;
-          if (P.bits.D)
-            value8 -= 0x0066;
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xED) :  // ABS SBC
+          load<ABS, SBC>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xEE :  // ABS INC
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          value8 = mmu->readMem(address);
-          value8++;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
+        OPCODE(0xEE) :  // ABS INC
+          modify<ABS, INC>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0xEF :  // ZPR BBS
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (value8 & 64)
-            PC += address;
+        OPCODE(0xEF) :  // ZPR BBS
+          branchBit<6, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xF0 :  // REL BEQ
-          address = mmu->readMem(PC);
-          PC++;
-          if (P.bits.Z) {  // branch taken
-            ticks++;
-            if (address & SIGN)
-              address |= 0xFF00;  // jump backward
-            if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-              ticks++;
-            PC += address;
-          }
+        OPCODE(0xF0) :  // REL BEQ
+          branch<ZERO, true>();
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xF1 :  // IZY SBC
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          if ((address + Y) & 0xFF00)  // page crossing
-            ticks++;
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          address += Y;
-          value8 = mmu->readMem(address);
-          value8 ^= 0xFF;
-          if (P.bits.D)
-            value8 -= 0x0066;
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xF1) :  // IZY SBC
+          load<IZY, SBC>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xF2 :  // IZP SBC
-          value8 = mmu->readMem(PC);
-          PC++;
-          address = mmu->readMem(value8);
-          value8++;
-          address |= mmu->readMem(value8) << 8;
-          value8 = mmu->readMem(address);
-          value8 ^= 0xFF;
-          if (P.bits.D)
-            value8 -= 0x0066;
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xF2) :  // IZP SBC
+          load<IZP, SBC>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xF3 :  // IMP NOP
+        OPCODE(0xF3) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0xF4 :  // ZPX NOP
+        OPCODE(0xF4) :  // ZPX NOP
           PC++;
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xF5 :  // ZPX SBC
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          value8 = mmu->readMem(address);
-          value8 ^= 0xFF;
-          if (P.bits.D)
-            value8 -= 0x0066;
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xF5) :  // ZPX SBC
+          load<ZPX, SBC>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xF6 :  // ZPX INC
-          address = (mmu->readMem(PC) + X) & 0xFF;
-          PC++;
-          value8 = mmu->readMem(address);
-          value8++;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
+        OPCODE(0xF6) :  // ZPX INC
+          modify<ZPX, INC>();
           ticks += 6;
-        break;
+        NEXT;
 
-        case 0xF7 :  // ZPG SMB
-          address = mmu->readMem(PC);
-          PC++;
-          mmu->writeMem(address, mmu->readMem(address) | 128);
+        OPCODE(0xF7) :  // ZPG SMB
+          changeBit<7, true>();
           ticks += 5;
-        break;
+        NEXT;
 
-        case 0xF8 :  // IMP SED
+        OPCODE(0xF8) :  // IMP SED
           P.bits.D = 1;
           ticks += 2;
-        break;
+        NEXT;
 
-        case 0xF9 :  // ABY SBC
-          address = mmu->readMem(PC);
-          PC++;
-          if ((address + Y) & 0xFF00)  // page crossing
-            ticks++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += Y;
-          value8 = mmu->readMem(address);
-          value8 ^= 0xFF;
-          if (P.bits.D)
-            value8 -= 0x0066;
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C = value16 > 0xFF;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xF9) :  // ABY SBC
+          load<ABY, SBC>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xFA :  // IMP PLX
-          SP++;
-          X = mmu->readMem(0x100 + SP);
-          P.bits.Z = X == 0;
-          P.bits.S = X > 0x7F;
+        OPCODE(0xFA) :  // IMP PLX
+          setNZ(X = pull());
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xFB :  // IMP NOP
+        OPCODE(0xFB) :  // IMP NOP
           ticks++;
-        break;
+        NEXT;
 
-        case 0xFC :  // ABS NOP
+        OPCODE(0xFC) :  // ABS NOP
           PC += 2;
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xFD :  // ABX SBC
-          address = mmu->readMem(PC);
-          PC++;
-          if ((address + X) & 0xFF00)  // page crossing
-            ticks++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          value8 = mmu->readMem(address);
-          value8 ^= 0xFF;
-          if (P.bits.D)
-            value8 -= 0x0066;
-          value16 = A + value8 + P.bits.C;
-          P.bits.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-          if (P.bits.D)
-            value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-          P.bits.C =  (value16 & 0xFF00) != 0;
-          A = value16 & 0xFF;
-          P.bits.Z = A == 0;
-          P.bits.S = A > 0x7F;
+        OPCODE(0xFD) :  // ABX SBC
+          load<ABX, SBC>();
           ticks += 4;
-        break;
+        NEXT;
 
-        case 0xFE :  // ABX INC
-          address = mmu->readMem(PC);
-          PC++;
-          address |= mmu->readMem(PC) << 8;
-          PC++;
-          address += X;
-          value8 = mmu->readMem(address);
-          value8++;
-          mmu->writeMem(address, value8);
-          P.bits.Z = value8 == 0;
-          P.bits.S = value8 > 0x7F;
+        OPCODE(0xFE) :  // ABX INC
+          modify<ABX, INC>();
           ticks += 7;
-        break;
+        NEXT;
 
-        case 0xFF :  // ZPR BBS
-          value8 = mmu->readMem(mmu->readMem(PC));
-          PC++;
-          address = mmu->readMem(PC);
-          PC++;
-          if (address & SIGN)
-            address |= 0xFF00;  // jump backward
-          if (value8 & 128)
-            PC += address;
+        OPCODE(0xFF) :  // ZPR BBS
+          branchBit<7, true>();
           ticks += 5;
-        break;
+        NEXT;
 
+#ifndef THREADED
       } // end of switch
   }  // end of while
+#else
+done:
+#endif
+#ifdef TRACE
+  trace->count = traceCount;
+#endif
   return PC;
 }
 
+#ifdef THREADED
+#pragma GCC diagnostic pop
+#endif
+
 
 // utilities  // to be moved into gui ??
 
@@ -2599,39 +1744,46 @@ static const int am[256] = {
    0x6 , 0xD , 0xB , 0x0 , 0x4 , 0x4 , 0x4 , 0x3 , 0x0 , 0x9 , 0x0 , 0x0 , 0x7 , 0x8 , 0x8 , 0xE
  };
 
+int puce65c02::disassemble(uint16_t address, const uint8_t* bytes, char* buffer, int size) {
+  uint8_t op = bytes[0];
+  uint8_t b1 = bytes[1];
+  uint8_t b2 = bytes[2];
+  switch(am[op]) {
+    case 0x0: snprintf(buffer, size, "%04X %02X        %s          ", address, op,              mn[op]      ); return 1;  // implied
+    case 0x1: snprintf(buffer, size, "%04X %02X        %s A        ", address, op,              mn[op]      ); return 1;  // accumulator
+    case 0x2: snprintf(buffer, size, "%04X %02X %02X     %s #$%02X     ", address, op,    b1,   mn[op],b1   ); return 2;  // immediate
+    case 0x3: snprintf(buffer, size, "%04X %02X %02X     %s $%02X      ", address, op,    b1,   mn[op],b1   ); return 2;  // zero page
+    case 0x4: snprintf(buffer, size, "%04X %02X %02X     %s $%02X,X    ", address, op,    b1,   mn[op],b1   ); return 2;  // zero page, X indexed
+    case 0x5: snprintf(buffer, size, "%04X %02X %02X     %s $%02X,Y    ", address, op,    b1,   mn[op],b1   ); return 2;  // zero page, Y indexed
+    case 0x6: snprintf(buffer, size, "%04X %02X %02X     %s $%02X      ", address, op,    b1,   mn[op],b1   ); return 2;  // relative
+    case 0xB: snprintf(buffer, size, "%04X %02X %02X     %s ($%02X)    ", address, op,    b1,   mn[op],b1   ); return 2;  // izp ($00)
+    case 0xC: snprintf(buffer, size, "%04X %02X %02X     %s ($%02X,X)  ", address, op,    b1,   mn[op],b1   ); return 2;  // X indexed, indirect
+    case 0xD: snprintf(buffer, size, "%04X %02X %02X     %s ($%02X),Y  ", address, op,    b1,   mn[op],b1   ); return 2;  // indirect, Y indexed
+    case 0x7: snprintf(buffer, size, "%04X %02X %02X%02X   %s $%02X%02X    ", address, op, b1,b2,mn[op],b2,b1); return 3;  // absolute
+    case 0x8: snprintf(buffer, size, "%04X %02X %02X%02X   %s $%02X%02X,X  ", address, op, b1,b2,mn[op],b2,b1); return 3;  // absolute, X indexed
+    case 0x9: snprintf(buffer, size, "%04X %02X %02X%02X   %s $%02X%02X,Y  ", address, op, b1,b2,mn[op],b2,b1); return 3;  // absolute, Y indexed
+    case 0xA: snprintf(buffer, size, "%04X %02X %02X%02X   %s ($%02X%02X)  ", address, op, b1,b2,mn[op],b2,b1); return 3;  // indirect
+    case 0xF: snprintf(buffer, size, "%04X %02X %02X%02X   %s ($%02X%02X,X)", address, op, b1,b2,mn[op],b2,b1); return 3;  // iax ($0000,X)
+    case 0xE: snprintf(buffer, size, "%04X %02X %02X%02X   %s $%02X,$%02X  ", address, op, b1,b2,mn[op],b2,b1); return 3;  // zpr $00,$00
+  }
+  return 1;
+}
+
 int puce65c02::getCode(uint16_t address, char* buffer, int size, int numLines) {
   int consumed = 0;
 
   for (int i=0; i<numLines; i++) {
-    uint8_t op = mmu->readMem(address);
-    uint8_t b1 = mmu->readMem((address + 1) & 0xFFFF);
-    uint8_t b2 = mmu->readMem((address + 2) & 0xFFFF);
-    consumed += snprintf(buffer + consumed, size - consumed, "%04X %02X ", address, op);
-    switch(am[op]) {
-      case 0x0: consumed += snprintf(buffer + consumed, size - consumed, "       %s          ",              mn[op]      ); address+=1; break;  // implied
-      case 0x1: consumed += snprintf(buffer + consumed, size - consumed, "       %s A        ",              mn[op]      ); address+=1; break;  // accumulator
-      case 0x2: consumed += snprintf(buffer + consumed, size - consumed, "%02X     %s #$%02X     ",    b1,   mn[op],b1   ); address+=2; break;  // immediate
-      case 0x3: consumed += snprintf(buffer + consumed, size - consumed, "%02X     %s $%02X      ",    b1,   mn[op],b1   ); address+=2; break;  // zero page
-      case 0x4: consumed += snprintf(buffer + consumed, size - consumed, "%02X     %s $%02X,X    ",    b1,   mn[op],b1   ); address+=2; break;  // zero page, X indexed
-      case 0x5: consumed += snprintf(buffer + consumed, size - consumed, "%02X     %s $%02X,Y    ",    b1,   mn[op],b1   ); address+=2; break;  // zero page, Y indexed
-      case 0x6: consumed += snprintf(buffer + consumed, size - consumed, "%02X     %s $%02X      ",    b1,   mn[op],b1   ); address+=2; break;  // relative
-      case 0xB: consumed += snprintf(buffer + consumed, size - consumed, "%02X     %s ($%02X)    ",    b1,   mn[op],b1   ); address+=2; break;  // izp ($00)
-      case 0xC: consumed += snprintf(buffer + consumed, size - consumed, "%02X     %s ($%02X,X)  ",    b1,   mn[op],b1   ); address+=2; break;  // X indexed, indirect
-      case 0xD: consumed += snprintf(buffer + consumed, size - consumed, "%02X     %s ($%02X),Y  ",    b1,   mn[op],b1   ); address+=2; break;  // indirect, Y indexed
-      case 0x7: consumed += snprintf(buffer + consumed, size - consumed, "%02X%02X   %s $%02X%02X    ",b1,b2,mn[op],b2,b1); address+=3; break;  // absolute
-      case 0x8: consumed += snprintf(buffer + consumed, size - consumed, "%02X%02X   %s $%02X%02X,X  ",b1,b2,mn[op],b2,b1); address+=3; break;  // absolute, X indexed
-      case 0x9: consumed += snprintf(buffer + consumed, size - consumed, "%02X%02X   %s $%02X%02X,Y  ",b1,b2,mn[op],b2,b1); address+=3; break;  // absolute, Y indexed
-      case 0xA: consumed += snprintf(buffer + consumed, size - consumed, "%02X%02X   %s ($%02X%02X)  ",b1,b2,mn[op],b2,b1); address+=3; break;  // indirect
-      case 0xF: consumed += snprintf(buffer + consumed, size - consumed, "%02X%02X   %s ($%02X%02X,X)",b1,b2,mn[op],b2,b1); address+=3; break;  // iax ($0000,X)
-      case 0xE: consumed += snprintf(buffer + consumed, size - consumed, "%02X%02X   %s $%02X,$%02X  ",b1,b2,mn[op],b2,b1); address+=3; break;  // zpr $00,$00
-    }
+    uint8_t bytes[3] = { mmu->readMem(address), mmu->readMem((address + 1) & 0xFFFF), mmu->readMem((address + 2) & 0xFFFF) };
+    address += disassemble(address, bytes, buffer + consumed, size - consumed);
+    consumed += strlen(buffer + consumed);
     consumed += snprintf(buffer + consumed, size - consumed, "\n");
   }
   return consumed;
 }
 
 int puce65c02::getRegs(char* buffer) {
+  uint8_t p = getP();
   return (snprintf(buffer, 100, "A=%02X  X=%02X  Y=%02X  S=%02X  *S=%02X\nPC=%04X  P=%c%c%c%c%c%c%c%c", \
   A, X, Y, SP, mmu->readMem(0x100 + SP), PC, \
-  P.bits.S?'N':'-', P.bits.V?'V':'-', P.bits.U?'U':'.', P.bits.B?'B':'-', P.bits.D?'D':'-', P.bits.I?'I':'-', P.bits.Z?'Z':'-', P.bits.C?'C':'-'));
+  p & SIGN?'N':'-', P.bits.V?'V':'-', P.bits.U?'U':'.', P.bits.B?'B':'-', P.bits.D?'D':'-', P.bits.I?'I':'-', p & ZERO?'Z':'-', P.bits.C?'C':'-'));
 }
@@ -1,90 +1,134 @@
-/*
-  puce65c02, a WDC 65c02 cpu emulator, based on puce6502 by the same author
-
-  Last modified 1st of July 2021
-
-  Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
-
-  Permission is hereby granted, free of charge, to any person obtaining a copy
-  of this software and associated documentation files (the "Software"), to deal
-  in the Software without restriction, including without limitation the rights
-  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-  copies of the Software, and to permit persons to whom the Software is
-  furnished to do so, subject to the following conditions:
-
-  The above copyright notice and this permission notice shall be included in
-  all copies or substantial portions of the Software.
-
-  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
-  THE SOFTWARE.
-*/
-
-/*
-  This version is slightly modified for reinette IIe, a french Apple IIe
-  emulator using SDL2 (https://github.com/ArthurFerreira2/reinette-IIe).
-  Please download the latest version from
-  https://github.com/ArthurFerreira2/puce65c02
-*/
-
-
-#ifndef _PUCE65C02_H
-#define _PUCE65C02_H
-
-typedef enum {run, step, stop, wait} status;
-
-#define CARRY 0x01
-#define ZERO  0x02
-#define INTR  0x04
-#define DECIM 0x08
-#define BREAK 0x10
-#define UNDEF 0x20
-#define OFLOW 0x40
-#define SIGN  0x80
-
-typedef struct Pbits_t {
-  uint8_t C : 1;          // Carry
-  uint8_t Z : 1;          // Zero
-  uint8_t I : 1;          // Interupt disabled
-  uint8_t D : 1;          // Decimal
-  uint8_t B : 1;          // Break
-  uint8_t U : 1;          // Undefined
-  uint8_t V : 1;          // Overflow
-  uint8_t S : 1;          // Sign
-} Pbits;
-
-
-class puce65c02 {
-private:
-  uint16_t PC;            // Program Counter
-  uint8_t A, X, Y, SP;    // Accumulator, X and y indexes and Stack Pointer
-  union {
-    uint8_t byte;
-    Pbits bits;
-  } P;                    // Processor Status
-
-public:
-  unsigned long long int ticks;
-
-  status state;
-
-  puce65c02();
-  ~puce65c02();
-
-  void RST();
-  void IRQ();
-  void NMI();
-  uint16_t exec(unsigned long long int cycleCount);
-
-  uint16_t getPC();
-  void setPC(uint16_t address);
-
-  int getRegs(char* buffer);
-  int getCode(uint16_t address, char* buffer, int size, int numLines);
-};
-
-#endif
+/*
+  puce65c02, a WDC 65c02 cpu emulator, based on puce6502 by the same author
+
+  Last modified 1st of July 2021
+
+  Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/*
+  This version is slightly modified for reinette IIe, a french Apple IIe
+  emulator using SDL2 (https://github.com/ArthurFerreira2/reinette-IIe).
+  Please download the latest version from
+  https://github.com/ArthurFerreira2/puce65c02
+*/
+
+
+#ifndef _PUCE65C02_H
+#define _PUCE65C02_H
+
+typedef enum {run, step, stop, wait} status;
+
+#define CARRY 0x01
+#define ZERO  0x02
+#define INTR  0x04
+#define DECIM 0x08
+#define BREAK 0x10
+#define UNDEF 0x20
+#define OFLOW 0x40
+#define SIGN  0x80
+
+typedef struct Pbits_t {
+  uint8_t C : 1;          // Carry
+  uint8_t Z : 1;          // Zero
+  uint8_t I : 1;          // Interupt disabled
+  uint8_t D : 1;          // Decimal
+  uint8_t B : 1;          // Break
+  uint8_t U : 1;          // Undefined
+  uint8_t V : 1;          // Overflow
+  uint8_t S : 1;          // Sign
+} Pbits;
+
+
+typedef struct alignas(8) Registers_t {  // 8 bytes, copied at once into the TraceEntry
+  uint8_t A, X, Y, SP;    // Accumulator, X and y indexes and Stack Pointer
+  union {
+    uint8_t byte;
+    Pbits bits;
+  } P;                    // Processor Status, N and Z excepted : use getP() and setP()
+  uint8_t lastN;          // N is bit 7 of the last result,
+  uint8_t lastZ;          // Z is set when it was zero (BIT and TSB/TRB set them apart)
+} Registers;
+
+
+class puce65c02 : private Registers {
+private:
+  uint16_t PC;            // Program Counter
+
+  // building blocks of the opcode handlers, composed per opcode in exec()
+  enum Mode { IMM, ZPG, ZPX, ZPY, ABS, ABX, ABY, IZP, IZX, IZY };
+  enum Op { ORA, AND, EOR, ADC, SBC, CMP, CPX, CPY, BIT, LDA, LDX, LDY,
+            ASL, LSR, ROL, ROR, INC, DEC, TSB, TRB };
+
+  inline uint8_t read(uint16_t address);
+  inline void write(uint16_t address, uint8_t value);
+  inline uint8_t readZP(uint8_t address);
+  inline void writeZP(uint8_t address, uint8_t value);
+  template <Mode M> inline uint8_t readAt(uint16_t address);
+  template <Mode M> inline void writeAt(uint16_t address, uint8_t value);
+  inline uint8_t fetch();
+  inline uint16_t fetch16();
+  inline void push(uint8_t value);
+  inline uint8_t pull();
+  inline uint8_t getP();
+  inline void setP(uint8_t value);
+  inline void setNZ(uint8_t value);
+  inline void add(uint8_t value);
+  inline void compare(uint8_t reg, uint8_t value);
+  inline void jump(uint8_t offset);
+  template <Mode M, bool penalty> inline uint16_t address();
+  template <Op O> inline void operate(uint8_t value);
+  template <Op O> inline uint8_t modified(uint8_t value);
+  template <Mode M, Op O> inline void load();
+  template <Mode M, Op O, bool penalty = false> inline void modify();
+  template <Mode M> inline void store(uint8_t value);
+  template <uint8_t flag, bool set> inline void branch();
+  template <int bit, bool set> inline void branchBit();
+  template <int bit, bool set> inline void changeBit();
+#ifdef TRACE
+  inline uint8_t traced(struct TraceEntry_t* ring, unsigned long long int& count, uint8_t opcode);
+#endif
+
+public:
+  unsigned long long int ticks;
+
+  status state;
+
+  puce65c02();
+  ~puce65c02();
+
+  void RST();
+  void IRQ();
+  void NMI();
+  uint16_t exec(unsigned long long int cycleCount);
+
+  uint16_t getPC();
+  void setPC(uint16_t address);
+
+  int getRegs(char* buffer);
+  int getCode(uint16_t address, char* buffer, int size, int numLines);
+  int disassemble(uint16_t address, const uint8_t* bytes, char* buffer, int size);  // one instruction, returns its length
+
+  void saveState(State* state);
+  void loadState(State* state);
+};
+
+#endif
@@ -29,14 +29,24 @@
 #define VERSION "0.8.1"
 
 #include <cstdint>
+#include <cstddef>
 
+#include "state.h"
 #include "puce65c02.h"
 #include "mmu.h"
 #include "disk.h"
 #include "video.h"
-#include "speaker.h"
 #include "paddles.h"
+#include "heatmap.h"
+#include "trace.h"
+#include "rewind.h"
+#include "journal.h"
+#include "library.h"
+#ifndef HEADLESS                // no SDL audio, video or OpenGL in the headless build
+#include "speaker.h"
+#include "core.h"
 #include "gui.h"
+#endif
 
 
 extern bool muted;
@@ -44,13 +54,25 @@ extern int  volume;
 extern bool running;  // the entire application
 extern bool paused;   // the virtual machine
 extern float speed;
+extern bool  turbo;    // run as fast as possible
+extern float mhz;      // achieved emulated speed
 
 extern puce65c02* cpu;
 extern Mmu*       mmu;
 extern Disk*      disk;
 extern Video*     video;
-extern Speaker*   speaker;
 extern Paddles*   paddles;
+extern Heatmap*   heatmap;
+#ifdef TRACE
+extern Trace*     trace;
+#endif
+extern Journal*   journal;
+extern Library*   library;
+#ifndef HEADLESS
+extern Speaker*   speaker;
+extern Core*      core;
 extern Gui*       gui;
+extern Rewind*    history;
+#endif
 
 #endif
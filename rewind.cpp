@@ -0,0 +1,238 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "reinette.h"
+
+//===================================================================== CODEC
+
+// a delta is a list of runs, each a varint header (length << 1 | literal)
+// followed, for literal runs, by the XOR of the bytes. Other runs are equal.
+
+static void putVarint(std::vector<uint8_t>& out, size_t value) {
+  while (value >= 0x80) {
+    out.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t)value);
+}
+
+
+static size_t getVarint(const uint8_t*& p) {
+  size_t value = 0;
+  for (int shift = 0; ; shift += 7) {
+    value |= (size_t)(*p & 0x7F) << shift;
+    if (!(*p++ & 0x80)) return value;
+  }
+}
+
+
+static size_t sameBytes(const uint8_t* a, const uint8_t* b, size_t size) {      // length of the run of equal bytes
+  size_t i = 0;
+  uint64_t wa, wb;
+  while (i + 8 <= size) {                                                       // 8 at a time
+    memcpy(&wa, a + i, 8);
+    memcpy(&wb, b + i, 8);
+    if (wa != wb) break;
+    i += 8;
+  }
+  while (i < size && a[i] == b[i]) i++;
+  return i;
+}
+
+
+static void encode(const uint8_t* data, const uint8_t* ref, size_t size, std::vector<uint8_t>& out) {
+  out.clear();
+  size_t i = 0;
+  while (i < size) {
+    size_t same = sameBytes(data + i, ref + i, size - i);
+    if (same) putVarint(out, same << 1);
+    i += same;
+    if (i == size) break;
+
+    size_t start = i, equal = 0;                                                // literal run, until 8 equal bytes
+    while (i < size && equal < 8) {
+      equal = data[i] == ref[i] ? equal + 1 : 0;
+      i++;
+    }
+    i -= equal;
+    putVarint(out, ((i - start) << 1) | 1);
+    for (size_t j = start; j < i; j++)
+      out.push_back(data[j] ^ ref[j]);
+  }
+  out.shrink_to_fit();
+}
+
+
+static void xorDelta(const std::vector<uint8_t>& delta, uint8_t* data) {        // XOR the delta into data
+  const uint8_t* p = delta.data();
+  const uint8_t* end = p + delta.size();
+  while (p < end) {
+    size_t header = getVarint(p);
+    size_t length = header >> 1;
+    if (header & 1) {
+      for (size_t j = 0; j < length; j++)
+        data[j] ^= p[j];
+      p += length;
+    }
+    data += length;
+  }
+}
+
+
+//==================================================================== HISTORY
+
+Rewind::Rewind() {
+  budget = REWIND_BUDGET;
+  interval = REWIND_INTERVAL;
+  used = 0;
+  decodedIndex = -1;
+  cursor = -1;
+  sinceKey = 0;
+  nextTick = 0;
+  state = new State();
+}
+
+
+Rewind::~Rewind() {
+  delete state;
+}
+
+
+void Rewind::update() {                                                         // called while the emulation runs
+  if (cursor >= 0) truncate();                                                  // running again from a past capture
+  if (!budget || cpu->ticks < nextTick) return;
+  nextTick = cpu->ticks + (unsigned long long int)interval * CYCLES_PER_FRAME;
+  capture();
+}
+
+
+void Rewind::capture() {
+  state->snapshot();
+
+  Entry entry;
+  entry.ticks = cpu->ticks;
+  entry.key = entries.empty() || sinceKey >= REWIND_KEYFRAME;
+  if (entries.empty()) latest.assign(state->size, 0);                           // the oldest keyframe is against zeros
+
+  encode(state->data, latest.data(), state->size, entry.delta);
+  if (entry.key) {
+    latest.assign(state->data, state->data + state->size);
+    sinceKey = 0;
+  } else sinceKey++;
+
+  used += entry.delta.size();
+  entries.push_back(std::move(entry));
+  trim();
+}
+
+
+void Rewind::trim() {
+  while (used > budget) {
+    long next = 1;                                                              // the second keyframe
+    while (next < (long)entries.size() && !entries[next].key) next++;
+    if (next >= (long)entries.size()) return;                                   // keep at least one
+
+    keyframe(next);                                                             // becomes the oldest one,
+    used -= entries[next].delta.size();                                         // against zeros
+    std::vector<uint8_t> zeros(decoded.size(), 0);
+    encode(decoded.data(), zeros.data(), decoded.size(), entries[next].delta);
+    used += entries[next].delta.size();
+
+    for (long i = 0; i < next; i++) {
+      used -= entries.front().delta.size();
+      entries.pop_front();
+    }
+    decodedIndex -= next;
+    if (cursor >= 0) cursor = cursor >= next ? cursor - next : 0;
+  }
+}
+
+
+void Rewind::truncate() {
+  for (long i = (long)entries.size() - 1; i > cursor; i--) {
+    used -= entries.back().delta.size();
+    entries.pop_back();
+  }
+  if (decodedIndex > cursor) decodedIndex = -1;
+
+  long key = cursor;                                                            // new deltas go against its keyframe
+  while (!entries[key].key) key--;
+  keyframe(key);
+  latest = decoded;
+  sinceKey = cursor - key;
+  cursor = -1;
+}
+
+
+void Rewind::keyframe(long index) {                                             // walk the keyframes from the closest decoded one
+  if (decodedIndex < 0) {
+    decoded.assign(state->size, 0);
+    xorDelta(entries[0].delta, decoded.data());
+    decodedIndex = 0;
+  }
+  while (decodedIndex < index) {                                                // forward : XOR the next keyframes
+    do decodedIndex++; while (!entries[decodedIndex].key);
+    xorDelta(entries[decodedIndex].delta, decoded.data());
+  }
+  while (decodedIndex > index) {                                                // backward : XOR is its own inverse
+    xorDelta(entries[decodedIndex].delta, decoded.data());
+    do decodedIndex--; while (!entries[decodedIndex].key);
+  }
+}
+
+
+void Rewind::restore(long index) {
+  long key = index;
+  while (!entries[key].key) key--;
+  keyframe(key);
+
+  state->size = 0;
+  state->put(decoded.data(), decoded.size());
+  if (index != key) xorDelta(entries[index].delta, state->data);
+  state->restore();
+  cursor = index;
+  nextTick = cpu->ticks + (unsigned long long int)interval * CYCLES_PER_FRAME;
+}
+
+
+int Rewind::back() {
+  if (entries.empty() || cursor == 0) return 0;
+  restore(cursor < 0 ? (long)entries.size() - 1 : cursor - 1);
+  return 1;
+}
+
+
+int Rewind::forward() {
+  if (cursor < 0 || cursor + 1 >= (long)entries.size()) return 0;
+  restore(cursor + 1);
+  return 1;
+}
+
+
+double Rewind::seconds() {
+  if (entries.empty()) return 0.0;
+  return (entries.back().ticks - entries.front().ticks) / (1000000.0 * speed);
+}
@@ -0,0 +1,79 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __REWIND_H__
+#define __REWIND_H__
+
+#include <deque>
+#include <vector>
+
+// rewind history : a State is captured every few frames and stored as a XOR
+// delta, run length encoded, against the last keyframe. Keyframes are deltas
+// against the previous keyframe, the oldest one against zeros, so the floppies
+// and the untouched memory cost next to nothing. The oldest keyframes and their
+// deltas are dropped when the memory budget is exceeded.
+
+#define REWIND_INTERVAL 4                                                       // frames between captures
+#define REWIND_KEYFRAME 64                                                      // captures between keyframes
+#define REWIND_BUDGET   (32 << 20)                                              // bytes of history
+
+class Rewind {
+public:
+  size_t budget;                                                                // in bytes, 0 disables the captures
+  int interval;                                                                 // in frames
+  size_t used;                                                                  // bytes of encoded deltas
+
+  Rewind();
+  ~Rewind();
+
+  void update();                                                                // capture if an interval went by
+  int  back();                                                                  // restore the previous capture
+  int  forward();                                                               // or the next one, 0 if none
+  double seconds();                                                             // emulated time covered
+
+private:
+  typedef struct Entry_t {
+    unsigned long long int ticks;                                               // cpu->ticks when captured
+    bool key;                                                                   // keyframe or delta
+    std::vector<uint8_t> delta;                                                 // run length encoded XOR
+  } Entry;
+
+  std::deque<Entry> entries;                                                    // oldest first, always starts with a keyframe
+  std::vector<uint8_t> latest;                                                  // the newest keyframe, decoded
+  std::vector<uint8_t> decoded;                                                 // any keyframe, decoded for restore()
+  long decodedIndex;                                                            // its index in entries, -1 if none
+  long cursor;                                                                  // capture shown while scrubbing, -1 if live
+  int sinceKey;                                                                 // deltas since the newest keyframe
+  unsigned long long int nextTick;                                              // when to capture
+  State* state;
+
+  void capture();
+  void truncate();                                                              // forget the captures after the cursor
+  void trim();                                                                  // drop the oldest keyframes over budget
+  void keyframe(long index);                                                    // decode a keyframe
+  void restore(long index);
+};
+
+#endif
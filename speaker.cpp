@@ -26,6 +26,8 @@
 #include "reinette.h"
 
 Speaker::Speaker() {
+  lastTick = 0LL;
+  SPKR = false;
   if (SDL_Init(SDL_INIT_AUDIO) != 0) {
       printf("Error: %s\n", SDL_GetError());
       exit(EXIT_FAILURE);
@@ -38,13 +40,10 @@ Speaker::Speaker() {
 
 
 void Speaker::play() {
-  static unsigned long long int lastTick = 0LL;
-  static bool SPKR = false;                                                     // $C030 Speaker toggle
-
   SPKR = !SPKR;                                                                 // toggle speaker state
   Uint32 length = (int)((double)(cpu->ticks - lastTick) / 10.42f / speed);      // 1000000Hz / 96000Hz = 10.4166
   lastTick = cpu->ticks;
-  if (!muted) {
+  if (!muted && !turbo) {                                                       // no sound when running flat out
     if (length > audioBufferSize)
       SDL_QueueAudio(audioDevice, audioBuffer[2], audioBufferSize);             // silence
     else
@@ -77,3 +76,22 @@ void Speaker::setVolume(int newVolume) {
     audioBuffer[2][i]     = 0;                                                  // silence
   }
 }
+
+
+void Speaker::saveState(State* s) {
+  s->begin("SPKR");
+  s->put(lastTick);
+  s->put((uint8_t)SPKR);
+  s->end();
+}
+
+
+void Speaker::loadState(State* s) {
+  uint8_t flag;
+  s->open("SPKR");
+  s->get(lastTick);
+  s->get(flag);
+  SPKR = flag != 0;
+  s->close();
+  SDL_ClearQueuedAudio(audioDevice);                                            // drop what was queued before
+}
@@ -37,7 +37,13 @@ public:
   void toggleMute();
   void setVolume(int newVolume);
 
+  void saveState(State* state);
+  void loadState(State* state);
+
 private:
+  unsigned long long int lastTick;                                              // cpu->ticks at the last toggle
+  bool SPKR;                                                                    // $C030 Speaker toggle
+
   int8_t audioBuffer[3][audioBufferSize];
   SDL_AudioDeviceID audioDevice;
 };
@@ -0,0 +1,183 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "reinette.h"
+
+static const char* sections[] = { "CPU ", "MMU ", "DISK", "VID ", "PADL", "SPKR" }; // in this order
+#define SECTIONS (sizeof(sections) / sizeof(sections[0]))
+
+State::State() {
+  capacity = 1 << 20;                                                           // a state is about 570KB, mostly the floppies
+  data = (uint8_t*)malloc(capacity);
+  size = 0;
+  pos = 0;
+  section = 0;
+}
+
+
+State::~State() {
+  free(data);
+}
+
+
+//======================================================================= SAVE
+
+void State::put(const void* src, size_t length) {
+  if (size + length > capacity) {
+    while (size + length > capacity) capacity *= 2;
+    data = (uint8_t*)realloc(data, capacity);
+  }
+  memcpy(data + size, src, length);
+  size += length;
+}
+
+
+void State::begin(const char* tag) {
+  put(tag, 4);
+  section = size;
+  put((uint32_t)0);                                                             // length, set by end()
+}
+
+
+void State::end() {
+  uint32_t length = size - section - sizeof(uint32_t);
+  memcpy(data + section, &length, sizeof(length));
+}
+
+
+void State::snapshot() {
+  size = 0;
+  put((uint32_t)STATE_MAGIC);
+  put((uint32_t)STATE_VERSION);
+
+  cpu->saveState(this);
+  mmu->saveState(this);
+  disk->saveState(this);
+  video->saveState(this);
+  paddles->saveState(this);
+#ifndef HEADLESS
+  speaker->saveState(this);
+#else
+  begin("SPKR");                                                                // no speaker, keep the layout
+  put(cpu->ticks);
+  put((uint8_t)0);
+  end();
+#endif
+}
+
+
+//==================================================================== RESTORE
+
+void State::get(void* dst, size_t length) {
+  if (pos + length > section) {                                                 // never read past the current section
+    memset(dst, 0, length);
+    return;
+  }
+  memcpy(dst, data + pos, length);
+  pos += length;
+}
+
+
+void State::open(const char* tag) {
+  uint32_t length;
+  memcpy(&length, data + pos + 4, sizeof(length));                              // tag already checked by validate()
+  pos += 8;
+  section = pos + length;
+}
+
+
+void State::close() {
+  pos = section;                                                                // skip what was not read
+}
+
+
+int State::validate() {                                                         // check everything before touching the machine
+  uint32_t header[2];
+  if (size < sizeof(header)) return 0;
+  memcpy(header, data, sizeof(header));
+  if (header[0] != STATE_MAGIC || header[1] != STATE_VERSION) return 0;
+
+  size_t at = sizeof(header);
+  for (size_t i = 0; i < SECTIONS; i++) {
+    uint32_t length;
+    if (at + 8 > size || memcmp(data + at, sections[i], 4)) return 0;
+    memcpy(&length, data + at + 4, sizeof(length));
+    at += 8 + length;
+  }
+  return at == size;                                                            // sections cover the whole state
+}
+
+
+int State::restore() {
+  if (!validate()) return 0;
+  pos = 2 * sizeof(uint32_t);
+
+  cpu->loadState(this);
+  mmu->loadState(this);
+  disk->loadState(this);
+  video->loadState(this);
+  paddles->loadState(this);
+#ifndef HEADLESS
+  speaker->loadState(this);
+#else
+  open("SPKR");
+  close();
+#endif
+  return 1;
+}
+
+
+//====================================================================== FILES
+
+int State::write(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return 0;
+  int ok = fwrite(data, 1, size, f) == size;
+  fclose(f);
+  return ok;
+}
+
+
+int State::read(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return 0;
+  fseek(f, 0, SEEK_END);
+  long length = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (length < 0) {
+    fclose(f);
+    return 0;
+  }
+  if ((size_t)length > capacity) {
+    capacity = length;
+    data = (uint8_t*)realloc(data, capacity);
+  }
+  size = fread(data, 1, length, f);
+  fclose(f);
+  return size == (size_t)length;
+}
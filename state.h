@@ -0,0 +1,69 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __STATE_H__
+#define __STATE_H__
+
+// machine snapshots : CPU, memory and soft switches, disk drives, video beam,
+// paddles and speaker, kept in memory and optionally written to a file.
+//
+// format : "RNTS" magic, version, then one section per component, each made of
+// a 4 char tag, a 32 bits length and the raw fields in host byte order. A state
+// is only restored if its version and sections match the ones of this build.
+
+#define STATE_MAGIC   0x53544E52                                                // "RNTS"
+#define STATE_VERSION 5
+
+class State {
+public:
+  uint8_t* data;                                                                // the snapshot
+  size_t   size;                                                                // bytes used in data
+  size_t   capacity;                                                            // bytes allocated, kept between snapshots
+
+  State();
+  ~State();
+
+  void snapshot();                                                              // capture the whole machine
+  int  restore();                                                               // 0 if data is not a valid state
+  int  write(const char* path);
+  int  read(const char* path);
+
+  void begin(const char* tag);                                                  // used by the components
+  void end();                                                                   // to save their fields
+  void put(const void* src, size_t length);
+  template <typename T> void put(const T& value) { put(&value, sizeof(T)); }
+
+  void open(const char* tag);                                                   // and to load them back
+  void close();
+  void get(void* dst, size_t length);
+  template <typename T> void get(T& value) { get(&value, sizeof(T)); }
+
+private:
+  size_t pos;                                                                   // read position in data
+  size_t section;                                                               // start of the current section
+  int    validate();
+};
+
+#endif
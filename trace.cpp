@@ -0,0 +1,98 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "reinette.h"
+
+Trace::Trace() {
+  clear();
+}
+
+
+void Trace::clear() {
+  memset(entries, 0, sizeof(entries));
+  count = 0;
+}
+
+
+int Trace::size() {
+  return count < TRACE_SIZE ? (int)count : TRACE_SIZE;
+}
+
+
+const TraceEntry& Trace::at(int age) {
+  return entries[(count - 1 - age) & (TRACE_SIZE - 1)];
+}
+
+
+unsigned long long int Trace::ticks(const TraceEntry& e) {                      // the ring spans far less than 2^32 cycles
+  return cpu->ticks - (uint32_t)((uint32_t)cpu->ticks - e.ticks);
+}
+
+
+uint8_t Trace::flags(const TraceEntry& e) {                                     // as puce65c02::getP()
+  return (e.regs.P.byte & ~(SIGN | ZERO)) | (e.regs.lastN & SIGN) | (e.regs.lastZ ? 0 : ZERO);
+}
+
+
+int Trace::list(char* buffer, int size, int lines) {                            // oldest first, the last one at the bottom
+  int consumed = 0;
+  buffer[0] = 0;
+  if (lines > this->size()) lines = this->size();
+
+  for (int age = lines - 1; age >= 0 && consumed < size; age--) {
+    const TraceEntry& e = at(age);
+    uint8_t p = flags(e);
+    consumed += snprintf(buffer + consumed, size - consumed, "%10llu ", ticks(e));
+    if (consumed >= size) break;
+    uint8_t bytes[3] = { e.opcode, mmu->peek(e.PC + 1), mmu->peek(e.PC + 2) };
+    cpu->disassemble(e.PC, bytes, buffer + consumed, size - consumed);
+    consumed += strlen(buffer + consumed);
+    consumed += snprintf(buffer + consumed, size - consumed, " A=%02X X=%02X Y=%02X S=%02X P=%c%c%c%c%c%c%c%c\n",
+                         e.regs.A, e.regs.X, e.regs.Y, e.regs.SP,
+                         p & SIGN ? 'N' : '-', p & OFLOW ? 'V' : '-', p & UNDEF ? 'U' : '.', p & BREAK ? 'B' : '-',
+                         p & DECIM ? 'D' : '-', p & INTR ? 'I' : '-', p & ZERO ? 'Z' : '-', p & CARRY ? 'C' : '-');
+  }
+  return consumed < size ? consumed : size - 1;
+}
+
+
+int Trace::dump(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return 0;
+
+  uint32_t header[3] = { TRACE_MAGIC, TRACE_VERSION, (uint32_t)size() };
+  bool ok = fwrite(header, sizeof(header), 1, f) == 1;
+  for (int age = size() - 1; ok && age >= 0; age--) {                           // 16 bytes per instruction
+    const TraceEntry& e = at(age);
+    unsigned long long int t = ticks(e);
+    uint8_t regs[5] = { e.regs.A, e.regs.X, e.regs.Y, e.regs.SP, flags(e) };
+    ok = fwrite(&t, sizeof(t), 1, f) && fwrite(&e.PC, sizeof(e.PC), 1, f)
+      && fwrite(&e.opcode, 1, 1, f) && fwrite(regs, sizeof(regs), 1, f);
+  }
+  fclose(f);
+  return ok;
+}
@@ -0,0 +1,69 @@
+/*
+ * reinette, a french Apple II emulator, using SDL2
+ * and powered by puce65c02 - a WDS 65c02 cpu emulator by the same author
+ * Last modified 1st of July 2021
+ * Copyright (c) 2021 Arthur Ferreira (arthur.ferreira2@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+// instruction trace, build with -DTRACE (make TRACE=1) to record it
+// a ring of the last TRACE_SIZE instructions run by the cpu : where, the
+// opcode, the registers before and the cycle count, to find out how the machine
+// ended up where it is. The operands are not recorded, the disassembly reads
+// them from memory as it is now.
+//
+// the cpu copies its Registers in one go, the cycle count and the N and Z
+// flags are only worked out when listed or dumped. Dumped to a file in host
+// byte order : "RNTT" magic, version, number of entries, then per entry, oldest
+// first, the cycle count (64 bits), PC (16 bits), opcode, A, X, Y, SP and P.
+
+#define TRACE_MAGIC   0x54544E52                                                // "RNTT"
+#define TRACE_VERSION 1
+#define TRACE_SIZE    0x10000                                                   // instructions kept, a power of 2
+
+typedef struct TraceEntry_t {
+  uint32_t ticks;                                                               // cycles count before the instruction, low bits
+  uint16_t PC;
+  uint8_t opcode;
+  Registers regs;                                                               // before the instruction, N and Z apart
+} TraceEntry;
+
+class Trace {
+public:
+  TraceEntry entries[TRACE_SIZE];                                               // filled by the cpu
+  unsigned long long int count;                                                 // instructions recorded so far
+
+  Trace();
+
+  void clear();
+  int  size();                                                                  // entries held, at most TRACE_SIZE
+  const TraceEntry& at(int age);                                                // 0 is the last one recorded
+  int  list(char* buffer, int size, int lines);                                 // the last ones, as disassembly
+  int  dump(const char* path);
+
+private:
+  unsigned long long int ticks(const TraceEntry& entry);                        // the whole cycles count
+  uint8_t flags(const TraceEntry& entry);                                       // P, with N and Z
+};
+
+#endif
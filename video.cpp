@@ -24,12 +24,78 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "reinette.h"
 
 
+// Note: Colors may vary, depending upon the controls on the monitor or TV set
+static const uint32_t lcolor[16] = {                                            // the 16 low res colors
+  0xFF000000, 0xFF5639E2, 0xFFCD741C, 0xFFAD6E7E,
+  0xFF80811F, 0xFF7A8289, 0xFFE4A856, 0xFFDFB290,
+  0xFF225897, 0xFF156CEA, 0xFF8F979E, 0xFFF0CEFF,
+  0xFF31C090, 0xFFA6FDFF, 0xFFD5D29F, 0xFFFFFFFF
+};
+
+static const uint32_t hcolor[16] = {                                            // the high res colors (light & dark levels)
+  0xFF000000, 0xFF31C090, 0xFFAD6E7E, 0xFFFFFFFF,
+  0xFF000000, 0xFF156CEA, 0xFFE4A856, 0xFFFFFFFF,
+  0xFF000000, 0xFF56373f, 0xFF196048, 0xFFFFFFFF,
+  0xFF000000, 0xFF72542B, 0xFF0A3675, 0xFFFFFFFF
+};
+
+static const uint32_t dhcolor[16] = {
+  0xFF000000, 0xFFCD741C, 0xFF80811F, 0xFFDFB290,
+  0xFF225897, 0xFF7A8289, 0xFF31C090, 0xFFE4A856,
+  0xFF5639E2, 0xFFAD6E7E, 0xFF8F979E, 0xFFD5D29F,
+  0xFF156CEA, 0xFFF0CEFF, 0xFFA6FDFF, 0xFFFFFFFF
+};
+
+static const uint16_t offsetGR[24] = {                                          // base addresses for each line in TEXT or GR
+  0x000, 0x080, 0x100, 0x180, 0x200, 0x280, 0x300, 0x380,                       // lines 0-7
+  0x028, 0x0A8, 0x128, 0x1A8, 0x228, 0x2A8, 0x328, 0x3A8,                       // lines 8-15
+  0x050, 0x0D0, 0x150, 0x1D0, 0x250, 0x2D0, 0x350, 0x3D0                        // lines 16-23
+};
+
+static const uint16_t offsetHGR[192] = {                                        // base addresses for each line in HGR
+  0x0000, 0x0400, 0x0800, 0x0C00, 0x1000, 0x1400, 0x1800, 0x1C00,               // lines 0-7
+  0x0080, 0x0480, 0x0880, 0x0C80, 0x1080, 0x1480, 0x1880, 0x1C80,               // lines 8-15
+  0x0100, 0x0500, 0x0900, 0x0D00, 0x1100, 0x1500, 0x1900, 0x1D00,               // lines 16-23
+  0x0180, 0x0580, 0x0980, 0x0D80, 0x1180, 0x1580, 0x1980, 0x1D80,
+  0x0200, 0x0600, 0x0A00, 0x0E00, 0x1200, 0x1600, 0x1A00, 0x1E00,
+  0x0280, 0x0680, 0x0A80, 0x0E80, 0x1280, 0x1680, 0x1A80, 0x1E80,
+  0x0300, 0x0700, 0x0B00, 0x0F00, 0x1300, 0x1700, 0x1B00, 0x1F00,
+  0x0380, 0x0780, 0x0B80, 0x0F80, 0x1380, 0x1780, 0x1B80, 0x1F80,
+  0x0028, 0x0428, 0x0828, 0x0C28, 0x1028, 0x1428, 0x1828, 0x1C28,
+  0x00A8, 0x04A8, 0x08A8, 0x0CA8, 0x10A8, 0x14A8, 0x18A8, 0x1CA8,
+  0x0128, 0x0528, 0x0928, 0x0D28, 0x1128, 0x1528, 0x1928, 0x1D28,
+  0x01A8, 0x05A8, 0x09A8, 0x0DA8, 0x11A8, 0x15A8, 0x19A8, 0x1DA8,
+  0x0228, 0x0628, 0x0A28, 0x0E28, 0x1228, 0x1628, 0x1A28, 0x1E28,
+  0x02A8, 0x06A8, 0x0AA8, 0x0EA8, 0x12A8, 0x16A8, 0x1AA8, 0x1EA8,
+  0x0328, 0x0728, 0x0B28, 0x0F28, 0x1328, 0x1728, 0x1B28, 0x1F28,
+  0x03A8, 0x07A8, 0x0BA8, 0x0FA8, 0x13A8, 0x17A8, 0x1BA8, 0x1FA8,
+  0x0050, 0x0450, 0x0850, 0x0C50, 0x1050, 0x1450, 0x1850, 0x1C50,
+  0x00D0, 0x04D0, 0x08D0, 0x0CD0, 0x10D0, 0x14D0, 0x18D0, 0x1CD0,
+  0x0150, 0x0550, 0x0950, 0x0D50, 0x1150, 0x1550, 0x1950, 0x1D50,
+  0x01D0, 0x05D0, 0x09D0, 0x0DD0, 0x11D0, 0x15D0, 0x19D0, 0x1DD0,
+  0x0250, 0x0650, 0x0A50, 0x0E50, 0x1250, 0x1650, 0x1A50, 0x1E50,
+  0x02D0, 0x06D0, 0x0AD0, 0x0ED0, 0x12D0, 0x16D0, 0x1AD0, 0x1ED0,               // lines 168-183
+  0x0350, 0x0750, 0x0B50, 0x0F50, 0x1350, 0x1750, 0x1B50, 0x1F50,               // lines 176-183
+  0x03D0, 0x07D0, 0x0BD0, 0x0FD0, 0x13D0, 0x17D0, 0x1BD0, 0x1FD0                // lines 184-191
+};
+
 Video::Video() {
-  memset(ramHeatmap, 0xFF000000, sizeof(ramHeatmap));
-  memset(auxHeatmap, 0xFF000000, sizeof(auxHeatmap));
+  frameNumber = 0;
+  mode = VM_TEXT;
+  modeTick = 0;
+  memset(lineMode,  VM_TEXT, sizeof(lineMode));
+  memset(drawnMode, 0xFF,    sizeof(drawnMode));                                // nothing drawn yet
+  flashPhase = false;
+  gfxmode = 40;
+  clearDrawn(0);
+  clearDrawn(1);
 
   // array from https://github.com/Michaelangel007/apple2_hgr_font_tutorial/
   const char FONT[] = {
@@ -180,6 +246,23 @@ Video::Video() {
       }
     }
   }
+
+  // Generate the HGR dots of every byte, for each value of the dot on its left
+  // and each parity of its column : one pixel every two is darker
+  for (int odd = 0; odd < 2; odd++) {
+    for (int pbit = 0; pbit < 2; pbit++) {
+      for (int byte = 0; byte < 256; byte++) {
+        int colorSet = (byte >> 7) * 4;                                         // bit 7 selects the color set
+        int left = pbit;
+        for (int x = 0; x < 7; x++) {
+          int bit = (byte >> x) & 1;
+          int even = ((odd + x) & 1) * 8;
+          hgrDots[odd][pbit][byte][x] = hcolor[even + colorSet + (bit << 1) + left];
+          left = bit;
+        }
+      }
+    }
+  }
 }
 
 
@@ -195,367 +278,383 @@ void Video::clearCache() {
   memset(previousBlocks, -2, sizeof(previousBlocks));
   memset(previousChars,  -2, sizeof(previousChars));
   memset(previousChars80,-2, sizeof(previousChars80));
+  memset(mmu->videoDirty, 1, sizeof(mmu->videoDirty));                          // and redraw every line
+}
+
+
+void Video::saveState(State* s) {                                               // the beam and the modes of the lines
+  s->begin("VID ");
+  s->put(mode);
+  s->put(lineMode);
+  s->put(modeTick);
+  s->put(frameNumber);
+  s->end();
+}
+
+
+void Video::loadState(State* s) {
+  s->open("VID ");
+  s->get(mode);
+  s->get(lineMode);
+  s->get(modeTick);
+  s->get(frameNumber);
+  s->close();
+
+  frameNumber %= 60;
+  memset(drawnMode, 0xFF, sizeof(drawnMode));                                   // nothing of it drawn yet
+  clearCache();
 }
 
 
+//======================================================================= BEAM
+
+int Video::beamLine() {                                                         // 0 to 191 visible, 192 to 261 blanked
+  return (int)((cpu->ticks % CYCLES_PER_FRAME) / CYCLES_PER_LINE);
+}
+
+
+bool Video::inVBL() {
+  return beamLine() >= 192;
+}
+
+
+void Video::setMode() {                                                         // called after a display soft switch access
+  uint8_t newMode = (mmu->TEXT       ? VM_TEXT    : 0) | (mmu->MIXED   ? VM_MIXED   : 0)
+                  | (mmu->PAGE2      ? VM_PAGE2   : 0) | (mmu->HIRES   ? VM_HIRES   : 0)
+                  | (mmu->DHIRES     ? VM_DHIRES  : 0) | (mmu->COL80   ? VM_COL80   : 0)
+                  | (mmu->ALTCHARSET ? VM_ALTCHAR : 0) | (mmu->STORE80 ? VM_STORE80 : 0);
+  if (newMode == mode) return;
+  catchUp();                                                                    // lines started until now used the old mode
+  mode = newMode;
+}
+
+
+void Video::catchUp() {
+  unsigned long long int line = modeTick / CYCLES_PER_LINE + 1;                 // first line started after the last change
+  unsigned long long int beam = cpu->ticks / CYCLES_PER_LINE;                   // line the beam is in now
+
+  if (beam >= line + LINES_PER_FRAME)                                           // at least a whole frame went by
+    line = beam - LINES_PER_FRAME + 1;
+  for (; line <= beam; line++)
+    if (line % LINES_PER_FRAME < 192)
+      lineMode[line % LINES_PER_FRAME] = mode;
+  modeTick = cpu->ticks;
+}
+
+
+//===================================================================== UPDATE
+
 void Video::update() {
+  setMode();                                                                    // in case a switch was changed from the GUI
+  catchUp();
+
+  for (int line = 0; line < 192; line++) {
+    if (drawnMode[line] != lineMode[line]) {                                    // this line is now shown in another mode,
+      memset(previousDots[line],        -2, sizeof(previousDots[line]));        // forget what was drawn there
+      memset(previousBlocks[line / 8],  -2, sizeof(previousBlocks[line / 8]));
+      memset(previousChars[line / 8],   -2, sizeof(previousChars[line / 8]));
+      memset(previousChars80[line / 8], -2, sizeof(previousChars80[line / 8]));
+    }
+  }
 
-  // Note: Colors may vary, depending upon the controls on the monitor or TV set
-  const uint32_t lcolor[16] = {                                                 // the 16 low res colors
-    0xFF000000, 0xFF5639E2, 0xFFCD741C, 0xFFAD6E7E,
-    0xFF80811F, 0xFF7A8289, 0xFFE4A856, 0xFFDFB290,
-    0xFF225897, 0xFF156CEA, 0xFF8F979E, 0xFFF0CEFF,
-    0xFF31C090, 0xFFA6FDFF, 0xFFD5D29F, 0xFFFFFFFF
-  };
+  bool flash = frameNumber % 30 < 16;                                           // FLASH characters are redrawn
+  bool flashChanged = flash != flashPhase;                                      // only when they blink
+  flashPhase = flash;
+
+  int first = 0;
+  while (first < 192) {                                                         // each run of lines sharing a mode
+    uint8_t m = lineMode[first];
+    int last = first + 1;
+    while (last < 192 && lineMode[last] == m)
+      last++;
+
+    int split = last;                                                           // graphics above, text below
+    if (m & VM_TEXT)
+      split = first;
+    else if (m & VM_MIXED)
+      split = first > 160 ? first : last < 160 ? last : 160;
+
+    drawLines(m, first, split, false, false);
+    drawLines(m, split, last, true, flashChanged);
+
+    if (last > split) gfxmode = (m & VM_COL80)  ? 80 : 40;                      // the bottom of the screen
+    else gfxmode = (m & VM_DHIRES) ? 80 : 40;                                   // selects the frame buffer
+    first = last;
+  }
 
-  const uint32_t hcolor[16] = {                                                 // the high res colors (light & dark levels)
-    0xFF000000, 0xFF31C090, 0xFFAD6E7E, 0xFFFFFFFF,
-    0xFF000000, 0xFF156CEA, 0xFFE4A856, 0xFFFFFFFF,
-    0xFF000000, 0xFF56373f, 0xFF196048, 0xFFFFFFFF,
-    0xFF000000, 0xFF72542B, 0xFF0A3675, 0xFFFFFFFF
-  };
+  memcpy(drawnMode, lineMode, sizeof(drawnMode));
+  memset(mmu->videoDirty, 0, sizeof(mmu->videoDirty));
 
-  const uint32_t dhcolor[16] = {
-    0xFF000000, 0xFFCD741C, 0xFF80811F, 0xFFDFB290,
-    0xFF225897, 0xFF7A8289, 0xFF31C090, 0xFFE4A856,
-    0xFF5639E2, 0xFFAD6E7E, 0xFF8F979E, 0xFFD5D29F,
-    0xFF156CEA, 0xFFF0CEFF, 0xFFA6FDFF, 0xFFFFFFFF
-  };
+#ifdef HEATMAP
+  heatmap->frame();                                                             // frame number for the HEATMAPS
+#endif
+}
 
-  const uint16_t offsetGR[24] = {                                               // base addresses for each line in TEXT or GR
-    0x000, 0x080, 0x100, 0x180, 0x200, 0x280, 0x300, 0x380,                     // lines 0-7
-    0x028, 0x0A8, 0x128, 0x1A8, 0x228, 0x2A8, 0x328, 0x3A8,                     // lines 8-15
-    0x050, 0x0D0, 0x150, 0x1D0, 0x250, 0x2D0, 0x350, 0x3D0                      // lines 16-23
-  };
 
-  const uint16_t offsetHGR[192] = {                                             // base addresses for each line in HGR
-    0x0000, 0x0400, 0x0800, 0x0C00, 0x1000, 0x1400, 0x1800, 0x1C00,             // lines 0-7
-    0x0080, 0x0480, 0x0880, 0x0C80, 0x1080, 0x1480, 0x1880, 0x1C80,             // lines 8-15
-    0x0100, 0x0500, 0x0900, 0x0D00, 0x1100, 0x1500, 0x1900, 0x1D00,             // lines 16-23
-    0x0180, 0x0580, 0x0980, 0x0D80, 0x1180, 0x1580, 0x1980, 0x1D80,
-    0x0200, 0x0600, 0x0A00, 0x0E00, 0x1200, 0x1600, 0x1A00, 0x1E00,
-    0x0280, 0x0680, 0x0A80, 0x0E80, 0x1280, 0x1680, 0x1A80, 0x1E80,
-    0x0300, 0x0700, 0x0B00, 0x0F00, 0x1300, 0x1700, 0x1B00, 0x1F00,
-    0x0380, 0x0780, 0x0B80, 0x0F80, 0x1380, 0x1780, 0x1B80, 0x1F80,
-    0x0028, 0x0428, 0x0828, 0x0C28, 0x1028, 0x1428, 0x1828, 0x1C28,
-    0x00A8, 0x04A8, 0x08A8, 0x0CA8, 0x10A8, 0x14A8, 0x18A8, 0x1CA8,
-    0x0128, 0x0528, 0x0928, 0x0D28, 0x1128, 0x1528, 0x1928, 0x1D28,
-    0x01A8, 0x05A8, 0x09A8, 0x0DA8, 0x11A8, 0x15A8, 0x19A8, 0x1DA8,
-    0x0228, 0x0628, 0x0A28, 0x0E28, 0x1228, 0x1628, 0x1A28, 0x1E28,
-    0x02A8, 0x06A8, 0x0AA8, 0x0EA8, 0x12A8, 0x16A8, 0x1AA8, 0x1EA8,
-    0x0328, 0x0728, 0x0B28, 0x0F28, 0x1328, 0x1728, 0x1B28, 0x1F28,
-    0x03A8, 0x07A8, 0x0BA8, 0x0FA8, 0x13A8, 0x17A8, 0x1BA8, 0x1FA8,
-    0x0050, 0x0450, 0x0850, 0x0C50, 0x1050, 0x1450, 0x1850, 0x1C50,
-    0x00D0, 0x04D0, 0x08D0, 0x0CD0, 0x10D0, 0x14D0, 0x18D0, 0x1CD0,
-    0x0150, 0x0550, 0x0950, 0x0D50, 0x1150, 0x1550, 0x1950, 0x1D50,
-    0x01D0, 0x05D0, 0x09D0, 0x0DD0, 0x11D0, 0x15D0, 0x19D0, 0x1DD0,
-    0x0250, 0x0650, 0x0A50, 0x0E50, 0x1250, 0x1650, 0x1A50, 0x1E50,
-    0x02D0, 0x06D0, 0x0AD0, 0x0ED0, 0x12D0, 0x16D0, 0x1AD0, 0x1ED0,             // lines 168-183
-    0x0350, 0x0750, 0x0B50, 0x0F50, 0x1350, 0x1750, 0x1B50, 0x1F50,             // lines 176-183
-    0x03D0, 0x07D0, 0x0BD0, 0x0FD0, 0x13D0, 0x17D0, 0x1BD0, 0x1FD0              // lines 184-191
-  };
+void Video::clearDrawn(int buffer) {                                            // the GUI has uploaded these lines
+  drawnFirst[buffer] = 192;
+  drawnLast[buffer]  = 0;
+}
+
+
+int Video::lineAddress(uint8_t m, int line, bool text) {                        // first byte shown on this line
+  if (text || !(m & VM_HIRES))
+    return ((m & VM_PAGE2) && !(text && (m & VM_COL80)) ? 0x0800 : 0x0400) + offsetGR[line / 8];
+  return ((m & VM_PAGE2) && !((m & VM_DHIRES) && (m & VM_STORE80)) ? 0x4000 : 0x2000) + offsetHGR[line];
+}
+
 
+void Video::drawLines(uint8_t m, int first, int last, bool text, bool redraw) { // draw the lines that changed
+  bool aux = text ? (m & VM_COL80) : (m & VM_DHIRES);                           // 80 columns modes also show AUX memory
+                                                                                // and are drawn in screenPixels80
+  int start = -1;                                                               // first line of a run to draw
 
-  // HIGH RES GRAPHICS
-  if (!mmu->TEXT && mmu->HIRES && !mmu->DHIRES) {
-    gfxmode = 40;
-    uint8_t colorIdx;                                                           // index to the color array
-    uint16_t word;
-    uint8_t bits[16], bit, pbit, colorSet, even;
-    int vRamBase = 0x2000 + mmu->PAGE2 * 0x2000;
-    int endRaw = mmu->MIXED ? 160 : 192;
-
-    for (int line = 0; line < endRaw; line++) {                                 // for every line
-      for (int col = 0; col < 40; col += 2) {                                   // for every 7 horizontal dots
-        word = (uint16_t)(mmu->ram[vRamBase + offsetHGR[line] + col + 1]) << 8; // store the two next bytes into 'word'
-        word += mmu->ram[vRamBase + offsetHGR[line] + col];                     // in reverse order
-
-        if (previousDots[line][col] != word) {                                  // check if this group of 7 dots need a redraw
-
-          int x = col * 7;
-          even = 0;
-
-          for (bit = 0; bit < 16; bit++)                                        // store all bits 'word' into 'bits'
-            bits[bit] = (word >> bit) & 1;
-          colorSet = bits[7] * 4;                                               // select the right color set
-          pbit = previousBit[line][col];                                        // the bit value of the left dot
-          bit = 0;                                                              // starting at 1st bit of 1st byte
-
-          while (bit < 15) {                                                    // until we reach bit7 of 2nd byte
-            if (bit == 7) {                                                     // moving into the second byte
-              colorSet = bits[15] * 4;                                          // update the color set
-              bit++;                                                            // skip bit 7
-            }
-
-            colorIdx = even + colorSet + (bits[bit] << 1) + (pbit);
-            screenPixels[line * 280 + x] =  hcolor[colorIdx];
-
-            x++;
-            pbit = bits[bit++];                                                 // proceed to the next pixel
-            even = even ? 0 : 8;                                                // one pixel every two is darker
-          }
-
-          previousDots[line][col] = word;                                       // update the video cache
-          if ((col < 37) && (previousBit[line][col + 2] != pbit)) {             // check color franging effect on the dot after
-            previousBit[line][col + 2] = pbit;                                  // set pbit and clear the
-            previousDots[line][col + 2] = -1;                                   // video cache for next dot
-          }
-        }                                                                       // if (previousDots[line][col] ...
+  for (int line = first; line <= last; line++) {
+    bool changed = false;
+    if (line < last) {
+      int block = lineAddress(m, line, text) >> 7;                              // a 40 bytes line never crosses a block
+      changed = redraw || drawnMode[line] != lineMode[line]
+             || mmu->videoDirty[MAIN_BANK][block] || (aux && mmu->videoDirty[AUX_BANK][block]);
+    }
+    if (changed && start < 0)
+      start = line;
+    else if (!changed && start >= 0) {
+      if (start < drawnFirst[aux]) drawnFirst[aux] = start;                     // remember what the GUI has to upload
+      if (line  > drawnLast[aux])  drawnLast[aux]  = line;
+
+      if (text) {
+        if (m & VM_COL80) drawText80(m, start, line);
+        else drawText40(m, start, line);
       }
+      else if (m & VM_HIRES) {
+        if (m & VM_DHIRES) drawDHGR(m, start, line);
+        else drawHGR(m, start, line);
+      }
+      else {
+        if (m & VM_DHIRES) drawDGR(m, start, line);
+        else drawGR(m, start, line);
+      }
+      start = -1;
     }
   }
+}
+
+
+//================================================================== RENDERERS
+
+// each renderer draws the scanlines first to last - 1 of the 192 visible ones
+// TEXT and GR rows cut by a mode change are redrawn and left out of the cache
+// 80 columns modes draw the even line of the 560x384 buffer and copy it below
 
-  // DOUBLE HIGH RES GRAPHICS
-  else if (!mmu->TEXT && mmu->HIRES && mmu->DHIRES) {
-    gfxmode = 80;
-    // int vRamBase = 0x2000 + PAGE2 * 0x2000;
-    int vRamBase = mmu->STORE80 ? 0x2000 : mmu->PAGE2 * 0x2000 + 0x2000;        // TODO : CHECK THIS !
-    int endRaw = mmu->MIXED ? 160 : 192;
-    uint32_t color;
-    uint32_t dword;
-
-    for (int line = 0; line < endRaw; line++) {
-      for (int col = 0, x = 0; col < 39; col+=2) {
-
-        int address = vRamBase + offsetHGR[line] + col;
-
-        // combine 4 bytes of memory, from MAIN and AUX
-        dword =  (uint32_t)(mmu->aux[address] & 0x7F);
-        dword |= (uint32_t)(mmu->ram[address] & 0x7F) << 7;
-        address++;
-        dword |= (uint32_t)(mmu->aux[address] & 0x7F) << 14;
-        dword |= (uint32_t)(mmu->ram[address] & 0x7F) << 21;
-
-        int offset1 = 560 * line * 2;
-        int offset2 = 560 + offset1;
-
-        for (int p=0; p<7; p++, dword >>= 4) {
-          color = dhcolor[dword & 0x0F];
-          for (int a=0; a<4; a++, x++) {   // draw 4x2 pixels
-            screenPixels80[offset1 + x] = color;
-            screenPixels80[offset2 + x] = color;
-          }
+static inline void fill4(uint32_t* pixel, uint32_t color) {                     // 4 pixels of the same color
+#ifdef __SSE2__
+  _mm_storeu_si128((__m128i*)pixel, _mm_set1_epi32((int)color));                // in a single store
+#else
+  pixel[0] = pixel[1] = pixel[2] = pixel[3] = color;
+#endif
+}
+
+
+static inline void fill7(uint32_t* pixel, uint32_t color) {                     // 7 pixels, two overlapping fill4
+  fill4(pixel, color);
+  fill4(pixel + 3, color);
+}
+
+
+// HIGH RES GRAPHICS
+void Video::drawHGR(uint8_t m, int first, int last) {
+  uint16_t word;
+  uint8_t pbit;
+  int vRamBase = (m & VM_PAGE2) ? 0x4000 : 0x2000;
+
+  for (int line = first; line < last; line++) {                                 // for every line
+    for (int col = 0; col < 40; col += 2) {                                     // for every 7 horizontal dots
+      word = (uint16_t)(mmu->ram[vRamBase + offsetHGR[line] + col + 1]) << 8;   // store the two next bytes into 'word'
+      word += mmu->ram[vRamBase + offsetHGR[line] + col];                       // in reverse order
+
+      if (previousDots[line][col] != word) {                                    // check if this group of 7 dots need a redraw
+        uint32_t* pixels = screenPixels + line * 280 + col * 7;
+        pbit = previousBit[line][col];                                          // the bit value of the left dot
+        memcpy(pixels,     hgrDots[0][pbit][word & 0xFF], sizeof(hgrDots[0][0][0]));  // even byte
+        pbit = (word >> 6) & 1;
+        memcpy(pixels + 7, hgrDots[1][pbit][word >> 8],   sizeof(hgrDots[0][0][0]));  // odd byte
+        pbit = (word >> 14) & 1;
+
+        previousDots[line][col] = word;                                         // update the video cache
+        if ((col < 37) && (previousBit[line][col + 2] != pbit)) {               // check color franging effect on the dot after
+          previousBit[line][col + 2] = pbit;                                    // set pbit and clear the
+          previousDots[line][col + 2] = -1;                                     // video cache for next dot
         }
-      }
+      }                                                                         // if (previousDots[line][col] ...
     }
   }
+}
 
-  // lOW RES GRAPHICS
-  else if (!mmu->TEXT && !mmu->HIRES && !mmu->DHIRES) {                         // and not in HIRES
-    gfxmode = 40;
-    int vRamBase = mmu->PAGE2 * 0x0400 + 0x400;
-    int endRaw = mmu->MIXED ? 20 : 24;
-    uint32_t color;
-    for (int col = 0; col < 40; col++) {                                        // for each column
-      int x = col * 7;
-      for (int line = 0; line < endRaw; line++) {                               // for each row
 
-        glyph = mmu->ram[vRamBase + offsetGR[line] + col];                      // read video memory
+// DOUBLE HIGH RES GRAPHICS
+void Video::drawDHGR(uint8_t m, int first, int last) {
+  int vRamBase = (m & VM_STORE80) ? 0x2000 : (m & VM_PAGE2) ? 0x4000 : 0x2000;  // TODO : CHECK THIS !
+  uint32_t dword;
 
-        if (previousBlocks[line][col] != glyph) {                               // check if this block need a redraw
-          previousBlocks[line][col] = glyph;
+  for (int line = first; line < last; line++) {
+    uint32_t* pixel = screenPixels80 + 560 * line * 2;
 
-          int y = line * 8;                                                     // first block
-          color = lcolor[glyph & 0x0F];                                         // first nibble
-          for (int a=0; a<7; a++)
-            for (int b=0; b<4; b++)
-              screenPixels[(y+b) * 280 + x + a] =  color;
+    for (int col = 0; col < 39; col+=2) {
+      int address = vRamBase + offsetHGR[line] + col;
 
-          y += 4;                                                               // second block
-          color = lcolor[(glyph & 0xF0) >> 4];                                  // second nibble
-          for (int a=0; a<7; a++)
-            for (int b=0; b<4; b++)
-              screenPixels[(y+b) * 280 + x + a] =  color;
-        }
-      }
+      // combine 4 bytes of memory, from MAIN and AUX
+      dword =  (uint32_t)(mmu->aux[address] & 0x7F);
+      dword |= (uint32_t)(mmu->ram[address] & 0x7F) << 7;
+      address++;
+      dword |= (uint32_t)(mmu->aux[address] & 0x7F) << 14;
+      dword |= (uint32_t)(mmu->ram[address] & 0x7F) << 21;
+
+      for (int p=0; p<7; p++, dword >>= 4, pixel += 4)                          // 7 dots, 4 pixels wide
+        fill4(pixel, dhcolor[dword & 0x0F]);
     }
+    memcpy(pixel, pixel - 560, 560 * sizeof(uint32_t));                         // and 2 lines high
   }
+}
+
+
+// lOW RES GRAPHICS
+void Video::drawGR(uint8_t m, int first, int last) {
+  int vRamBase = (m & VM_PAGE2) ? 0x0800 : 0x0400;
+  uint32_t color;
+
+  for (int row = first / 8; row * 8 < last; row++) {                            // for each row
+    int top    = row * 8 < first ? first - row * 8 : 0;                         // scanlines of this row to draw
+    int bottom = row * 8 + 8 > last ? last - row * 8 : 8;
+    bool whole = top == 0 && bottom == 8;
 
-  // DOUBLE lOW RES GRAPHICS
-  else if (!mmu->TEXT && !mmu->HIRES && mmu->DHIRES) {
-    gfxmode = 80;
-    int vRamBase = mmu->PAGE2 * 0x0400 + 0x400;    // TODO : CHECK THIS !
-    int endRaw = mmu->MIXED ? 20 : 24;
-    int x, y;
-    uint32_t color;
     for (int col = 0; col < 40; col++) {                                        // for each column
-      x = col * 14;
-      for (int line = 0; line < endRaw; line++) {                               // for each row
-        y = line * 16;                                                          // first block
+      glyph = mmu->ram[vRamBase + offsetGR[row] + col];                         // read video memory
 
-        glyph = mmu->aux[vRamBase + offsetGR[line] + col];                      // read AUX video memory
-        color = lcolor[glyph & 0x0F];                                           // first nibble
-        for (int a=0; a<7; a++)
-          for (int b=0; b<8; b++)
-            screenPixels80[(y+b) * 560 + (x+a)] = color;
+      if (whole && previousBlocks[row][col] == glyph) continue;                 // check if this block need a redraw
+      previousBlocks[row][col] = whole ? glyph : -2;
 
-        color = lcolor[(glyph & 0xF0) >> 4];                                    // second nibble
+      for (int y = top; y < bottom; y++) {
+        color = lcolor[y < 4 ? glyph & 0x0F : glyph >> 4];                      // first block, then second block
+        uint32_t* pixel = screenPixels + (row * 8 + y) * 280 + col * 7;
         for (int a=0; a<7; a++)
-          for (int b=8; b<16; b++)
-            screenPixels80[(y+b) * 560 + (x+a)] = color;
-
-        glyph = mmu->ram[vRamBase + offsetGR[line] + col];                      // read MAIN video memory
-        color = lcolor[glyph & 0x0F];                                           // first nibble
-        for (int a=7; a<14; a++)
-          for (int b=0; b<8; b++)
-            screenPixels80[(y+b) * 560 + (x+a)] = color;
-
-        color = lcolor[(glyph & 0xF0) >> 4];                                    // second nibble
-        for (int a=7; a<14; a++)
-          for (int b=8; b<16; b++)
-            screenPixels80[(y+b) * 560 + (x+a)] = color;
+          pixel[a] = color;
       }
     }
   }
+}
 
-  // TEXT 40 COLUMNS
-  if (!mmu->COL80 && (mmu->TEXT || mmu->MIXED)) {
-    gfxmode = 40;
-    int vRamBase = mmu->PAGE2 * 0x0400 + 0x400;
-    int startRaw = mmu->TEXT ? 0 : 20;
-    for (int col = 0; col < 40; col++) {                                        // for each column
-      for (int line = startRaw; line < 24; line++) {                            // for each row
-
-        glyph = mmu->ram[vRamBase + offsetGR[line] + col];                      // read video memory
-
-        if (glyph > 0x7F) glyphAttr = A_NORMAL;                                 // is NORMAL ?
-        else if (glyph < 0x40) glyphAttr = A_INVERSE;                           // is INVERSE ?
-        else glyphAttr = A_FLASH;                                               // it's FLASH !
-
-        if (previousChars[line][col] != (glyph <<(8*mmu->ALTCHARSET)) || glyphAttr == A_FLASH) {  // check if this char need a redraw
-          previousChars[line][col] = (glyph <<(8*mmu->ALTCHARSET));
-
-          glyph &= 0x7F;                                                        // unset bit 7
-          if (glyph < 0x20) glyph |= 0x40;                                      // shifts to match the ASCII codes
-
-          if ((!mmu->ALTCHARSET) && (glyphAttr == A_FLASH) && (glyph > 0x5F))
-            glyph &= 0x3F;
-
-          if (mmu->ALTCHARSET && (glyphAttr == A_FLASH)) {
-            if (glyph >= 0x40 && glyph < 0x60) {
-              glyph &= 0x3F;
-              glyphAttr = A_NORMAL;
-            }
-            else if (glyph >= 0x60)
-              glyphAttr = A_INVERSE;
-          }
-
-          if (glyphAttr == A_NORMAL || ((glyphAttr == A_FLASH) && (gui->frameNumber % 30 < 16))) {
-            for (int yy=0; yy<8; yy++)
-              for (int xx=0; xx<7; xx++)
-                screenPixels[(yy+line*8)*280 + (xx+(col*7))] = fontNormal[glyph][yy][xx];
-          }
-          else {
-            for (int yy=0; yy<8; yy++)
-              for (int xx=0; xx<7; xx++)
-                screenPixels[(yy+line*8)*280 + (xx+(col*7))] = fontInverse[glyph][yy][xx];
-          }
-        }
+
+// DOUBLE lOW RES GRAPHICS
+void Video::drawDGR(uint8_t m, int first, int last) {
+  int vRamBase = (m & VM_PAGE2) ? 0x0800 : 0x0400;    // TODO : CHECK THIS !
+
+  for (int row = first / 8; row * 8 < last; row++) {                            // for each row
+    int top    = row * 8 < first ? first - row * 8 : 0;
+    int bottom = row * 8 + 8 > last ? last - row * 8 : 8;
+
+    for (int y = top; y < bottom; y++) {
+      uint32_t* pixel = screenPixels80 + (row * 16 + y * 2) * 560;
+
+      for (int col = 0; col < 40; col++, pixel += 14) {                         // for each column
+        uint8_t auxGlyph  = mmu->aux[vRamBase + offsetGR[row] + col];           // read AUX video memory
+        uint8_t mainGlyph = mmu->ram[vRamBase + offsetGR[row] + col];           // read MAIN video memory
+        fill7(pixel,     lcolor[y < 4 ? auxGlyph  & 0x0F : auxGlyph  >> 4]);    // first nibble, then second nibble
+        fill7(pixel + 7, lcolor[y < 4 ? mainGlyph & 0x0F : mainGlyph >> 4]);
       }
+      memcpy(pixel, pixel - 560, 560 * sizeof(uint32_t));                       // line doubling
     }
   }
+}
+
+
+const uint32_t* Video::charBitmap(uint8_t code, bool altCharset) {             // the 8x7 dots to draw for a TEXT character
+  if (code > 0x7F) glyphAttr = A_NORMAL;                                        // is NORMAL ?
+  else if (code < 0x40) glyphAttr = A_INVERSE;                                  // is INVERSE ?
+  else glyphAttr = A_FLASH;                                                     // it's FLASH !
+
+  glyph = code & 0x7F;                                                          // unset bit 7
+  if (glyph < 0x20) glyph |= 0x40;                                              // shifts to match the ASCII codes
+
+  if ((!altCharset) && (glyphAttr == A_FLASH) && (glyph > 0x5F))
+    glyph &= 0x3F;
+
+  if (altCharset && (glyphAttr == A_FLASH)) {
+    if (glyph >= 0x40 && glyph < 0x60) {
+      glyph &= 0x3F;
+      glyphAttr = A_NORMAL;
+    }
+    else if (glyph >= 0x60)
+      glyphAttr = A_INVERSE;
+  }
+
+  if (glyphAttr == A_NORMAL || ((glyphAttr == A_FLASH) && (frameNumber % 30 < 16)))
+    return &fontNormal[glyph][0][0];
+  return &fontInverse[glyph][0][0];
+}
+
+
+// TEXT 40 COLUMNS
+void Video::drawText40(uint8_t m, int first, int last) {
+  int vRamBase = (m & VM_PAGE2) ? 0x0800 : 0x0400;
+  bool altCharset = m & VM_ALTCHAR;
 
-  // TEXT 80 COLUMNS
-  else if (mmu->COL80 && (mmu->TEXT || mmu->MIXED)) {
-    gfxmode = 80;
-    int startRaw = mmu->TEXT ? 0 : 20;
-    int vRamBase = 0x0400; // + PAGE2 * 0x400;
+  for (int row = first / 8; row * 8 < last; row++) {                            // for each row
+    int top    = row * 8 < first ? first - row * 8 : 0;
+    int bottom = row * 8 + 8 > last ? last - row * 8 : 8;
+    bool whole = top == 0 && bottom == 8;
 
     for (int col = 0; col < 40; col++) {                                        // for each column
-      for (int line = startRaw; line < 24; line++) {                            // for each row
-        glyph = mmu->ram[vRamBase + offsetGR[line] + col];                      // read video memory in Main memory
-
-        if (glyph > 0x7F) glyphAttr = A_NORMAL;                                 // is NORMAL ?
-        else if (glyph < 0x40) glyphAttr = A_INVERSE;                           // is INVERSE ?
-        else glyphAttr = A_FLASH;                                               // it's FLASH !
-
-        if (previousChars[line][col] != (glyph <<(8*mmu->ALTCHARSET)) || glyphAttr == A_FLASH) {  // check if this char need a redraw
-          previousChars[line][col] = (glyph <<(8*mmu->ALTCHARSET));
-
-          glyph &= 0x7F;                                                        // unset bit 7
-          if (glyph < 0x20) glyph |= 0x40;                                      // shifts to match the ASCII codes
-
-          if ((!mmu->ALTCHARSET) && (glyphAttr == A_FLASH) && (glyph > 0x5F))
-            glyph &= 0x3F;
-
-          if (mmu->ALTCHARSET && (glyphAttr == A_FLASH)) {
-            if (glyph >= 0x40 && glyph < 0x60) {
-              glyph &= 0x3F;
-              glyphAttr = A_NORMAL;
-            }
-            else if (glyph >= 0x60)
-              glyphAttr = A_INVERSE;
-          }
-
-          if (glyphAttr == A_NORMAL || ((glyphAttr == A_FLASH) && (gui->frameNumber % 30 < 16))) {
-            for (int yy=0; yy<16; yy+=2)
-              for (int xx=0; xx<7; xx++){
-                screenPixels80[(yy+line*16)*560 + (xx+(((col*2)+1)*7))] = fontNormal[glyph][yy/2][xx];
-                screenPixels80[(1+yy+line*16)*560 + (xx+(((col*2)+1)*7))] = fontNormal[glyph][yy/2][xx];
-              }
-          }
-          else {
-            for (int yy=0; yy<16; yy+=2)
-              for (int xx=0; xx<7; xx++){
-                screenPixels80[(yy+line*16)*560 + (xx+(((col*2)+1)*7))] = fontInverse[glyph][yy/2][xx];
-                screenPixels80[(1+yy+line*16)*560 + (xx+(((col*2)+1)*7))] = fontInverse[glyph][yy/2][xx];
-              }
-          }
-        }
+      uint8_t code = mmu->ram[vRamBase + offsetGR[row] + col];                  // read video memory
+      int cached = code << (8 * altCharset);
+      bool flash = code >= 0x40 && code < 0x80;
 
-        glyph = mmu->aux[vRamBase + offsetGR[line] + col];                      // read video memory in Auxiliary Memory
-
-        if (glyph > 0x7F) glyphAttr = A_NORMAL;                                 // is NORMAL ?
-        else if (glyph < 0x40) glyphAttr = A_INVERSE;                           // is INVERSE ?
-        else glyphAttr = A_FLASH;                                               // it's FLASH !
-
-        if (previousChars80[line][col] != (glyph <<(8*mmu->ALTCHARSET)) || glyphAttr == A_FLASH) {  // check if this char need a redraw
-          previousChars80[line][col] = (glyph <<(8*mmu->ALTCHARSET));
-
-          glyph &= 0x7F;                                                        // unset bit 7
-          if (glyph < 0x20) glyph |= 0x40;                                      // shifts to match the ASCII codes
-
-          if ((!mmu->ALTCHARSET) && (glyphAttr == A_FLASH) && (glyph > 0x5F))
-            glyph &= 0x3F;
-
-          if (mmu->ALTCHARSET && (glyphAttr == A_FLASH)) {
-            if (glyph >= 0x40 && glyph < 0x60) {
-              glyph &= 0x3F;
-              glyphAttr = A_NORMAL;
-            }
-            else if (glyph >= 0x60)
-              glyphAttr = A_INVERSE;
-          }
-
-          if (glyphAttr == A_NORMAL || ((glyphAttr == A_FLASH) && (gui->frameNumber % 30 < 16))) {
-            for (int yy=0; yy<16; yy+=2)
-              for (int xx=0; xx<7; xx++) {
-                screenPixels80[(yy+line*16)*560 + (xx+(col*2*7))] = fontNormal[glyph][yy/2][xx];
-                screenPixels80[(1+yy+line*16)*560 + (xx+(col*2*7))] = fontNormal[glyph][yy/2][xx];
-              }
-          }
-          else {
-            for (int yy=0; yy<16; yy+=2)
-              for (int xx=0; xx<7; xx++) {
-                screenPixels80[(yy+line*16)*560 + (xx+(col*2*7))] = fontInverse[glyph][yy/2][xx];
-                screenPixels80[(1+yy+line*16)*560 + (xx+(col*2*7))] = fontInverse[glyph][yy/2][xx];
-              }
-          }
-        }
-      }
+      if (whole && previousChars[row][col] == cached && !flash) continue;       // check if this char need a redraw
+      previousChars[row][col] = whole ? cached : -2;
+
+      const uint32_t* font = charBitmap(code, altCharset);
+      for (int yy = top; yy < bottom; yy++)
+        for (int xx=0; xx<7; xx++)
+          screenPixels[(yy+row*8)*280 + (xx+(col*7))] = font[yy*7 + xx];
     }
   }
+}
+
 
-  // update ram & aux HEATMAPS (fade out green and red components)
-  for (int address=0; address<65536; address++){
-    if (ramHeatmap[address] & 0x000000FF)
-      ramHeatmap[address]--;
-    if (ramHeatmap[address] & 0x0000FF00)
-    ramHeatmap[address] -= 256;
-
-    if (auxHeatmap[address] & 0x000000FF)
-      auxHeatmap[address]--;
-    if (auxHeatmap[address] & 0x0000FF00)
-    auxHeatmap[address] -= 256;
+// TEXT 80 COLUMNS
+void Video::drawText80(uint8_t m, int first, int last) {
+  int vRamBase = 0x0400; // + PAGE2 * 0x400;
+  bool altCharset = m & VM_ALTCHAR;
+  const uint32_t* fonts[80];                                                    // chars to draw on this row, or NULL
+
+  for (int row = first / 8; row * 8 < last; row++) {                            // for each row
+    int top    = row * 8 < first ? first - row * 8 : 0;
+    int bottom = row * 8 + 8 > last ? last - row * 8 : 8;
+    bool whole = top == 0 && bottom == 8;
+    bool drawn = false;
+
+    for (int col = 0; col < 40; col++) {                                        // for each column
+      for (int bank = 0; bank < 2; bank++) {                                    // MAIN chars are on the right of AUX ones
+        uint8_t code = bank ? mmu->ram[vRamBase + offsetGR[row] + col]          // read video memory in Main memory
+                            : mmu->aux[vRamBase + offsetGR[row] + col];         // or in Auxiliary Memory
+        int cached = code << (8 * altCharset);
+        bool flash = code >= 0x40 && code < 0x80;
+        int* previous = bank ? &previousChars[row][col] : &previousChars80[row][col];
+
+        fonts[col * 2 + bank] = NULL;
+        if (whole && *previous == cached && !flash) continue;                   // check if this char need a redraw
+        *previous = whole ? cached : -2;
+        fonts[col * 2 + bank] = charBitmap(code, altCharset);
+        drawn = true;
+      }
+    }
+    if (!drawn) continue;
+
+    for (int yy = top; yy < bottom; yy++) {
+      uint32_t* pixel = screenPixels80 + (yy * 2 + row * 16) * 560;
+      for (int c = 0; c < 80; c++)
+        if (fonts[c])
+          memcpy(pixel + c * 7, fonts[c] + yy * 7, 7 * sizeof(uint32_t));
+      memcpy(pixel + 560, pixel, 560 * sizeof(uint32_t));                       // line doubling
+    }
   }
 }
@@ -26,9 +26,23 @@
 #ifndef _VIDEO_H
 #define _VIDEO_H
 
+#define CYCLES_PER_LINE  65                                                     // 40 visible bytes and 25 of horizontal blank
+#define LINES_PER_FRAME  262                                                    // 192 visible lines and 70 of vertical blank
+#define CYCLES_PER_FRAME (CYCLES_PER_LINE * LINES_PER_FRAME)                    // 17030 cycles, about 60 Hz
+
+#define VM_TEXT    0x01                                                         // display soft switches,
+#define VM_MIXED   0x02                                                         // packed into a mode byte
+#define VM_PAGE2   0x04
+#define VM_HIRES   0x08
+#define VM_DHIRES  0x10
+#define VM_COL80   0x20
+#define VM_ALTCHAR 0x40
+#define VM_STORE80 0x80
+
 class Video {
 public:
   int gfxmode;
+  unsigned int frameNumber;                                                     // 0 to 59, for the FLASH characters
   uint8_t glyph;                                                                // a TEXT character, or 2 blocks in GR
   enum characterAttribute { A_NORMAL, A_INVERSE, A_FLASH } glyphAttr;           // character attribute in TEXT
   uint8_t previousBit[192][40] = {0};                                           // the last bit value of the byte before.
@@ -40,17 +54,42 @@ public:
 
   uint32_t fontNormal[128][8][7];                                               // normal font
   uint32_t fontInverse[128][8][7];                                              // reversed font
+  uint32_t hgrDots[2][2][256][7];                                               // HGR dots by column parity, left dot and byte
 
   uint32_t screenPixels[280*192] = {0xFF000000};
   uint32_t screenPixels80[560*384] = {0xFF000000};
-  uint32_t ramHeatmap[256*256] = {0xFF000000};
-  uint32_t auxHeatmap[256*256] = {0xFF000000};
+
+  uint8_t mode;                                                                 // current display soft switches
+  uint8_t lineMode[192];                                                        // mode in effect when the beam started each line
+  uint8_t drawnMode[192];                                                       // mode the pixels of each line were drawn with
+  unsigned long long int modeTick;                                              // cpu->ticks at the last mode change
+  bool flashPhase;                                                              // FLASH characters shown inverse or not
+  int drawnFirst[2];                                                            // lines drawn in screenPixels [0] and
+  int drawnLast[2];                                                             // screenPixels80 [1] since the last upload
 
   Video();
   ~Video();
 
   void update();
   void clearCache();
+  int beamLine();
+  bool inVBL();
+  void setMode();
+  void clearDrawn(int buffer);
+  void saveState(State* state);
+  void loadState(State* state);
+
+private:
+  void catchUp();
+  int lineAddress(uint8_t m, int line, bool text);
+  void drawLines(uint8_t m, int first, int last, bool text, bool redraw);
+  const uint32_t* charBitmap(uint8_t code, bool altCharset);
+  void drawHGR(uint8_t m, int first, int last);
+  void drawDHGR(uint8_t m, int first, int last);
+  void drawGR(uint8_t m, int first, int last);
+  void drawDGR(uint8_t m, int first, int last);
+  void drawText40(uint8_t m, int first, int last);
+  void drawText80(uint8_t m, int first, int last);
 };
 
 #endif